@@ -12,14 +12,37 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     puzzlewindow.cpp \
-    triangleanimationmodel.cpp
+    triangleanimationmodel.cpp \
+    animationclock.cpp \
+    puzzleloader.cpp \
+    puzzletexture.cpp \
+    tracerecorder.cpp \
+    tracereplayer.cpp \
+    puzzlerenderer.cpp \
+    frameprefetcher.cpp \
+    allocationcounter.cpp \
+    puzzlescene.cpp
 
 HEADERS  += \
     puzzlewindow.h \
     triangle.h \
-    triangleanimationmodel.h
+    triangleanimationmodel.h \
+    animationclock.h \
+    puzzleloader.h \
+    puzzletexture.h \
+    tracerecorder.h \
+    tracereplayer.h \
+    puzzlerenderer.h \
+    frameprefetcher.h \
+    allocationcounter.h \
+    puzzlescene.h
 
 FORMS    += mainwindow.ui
 
 RESOURCES += \
     application.qrc
+
+# benchmark build: qmake CONFIG+=count_allocations, replay reports heap allocations per frame
+count_allocations {
+    DEFINES += PUZZLE_COUNT_ALLOCATIONS
+}
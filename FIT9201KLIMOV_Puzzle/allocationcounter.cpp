@@ -0,0 +1,52 @@
+#include "allocationcounter.h"
+
+#include <cstdlib>
+
+#if defined(PUZZLE_COUNT_ALLOCATIONS) && defined(__GLIBC__)
+#define PUZZLE_ALLOCATION_HOOK
+
+namespace{
+    // frames prefetched by other threads are not counted to frames of GUI thread
+    __thread quint64 numAllocations = 0;
+}
+
+// Qt allocates data of images and containers by malloc(), operator new uses it too,
+// so malloc of glibc is wrapped by definitions of executable
+extern "C"{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+
+    void* malloc(size_t size){
+        numAllocations++;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size){
+        numAllocations++;
+        return __libc_calloc(count, size);
+    }
+
+    // shrinking is counted too, size of old block is unknown here
+    void* realloc(void* pointer, size_t size){
+        numAllocations++;
+        return __libc_realloc(pointer, size);
+    }
+}
+#endif
+
+bool AllocationCounter::isEnabled(){
+#ifdef PUZZLE_ALLOCATION_HOOK
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 AllocationCounter::count(){
+#ifdef PUZZLE_ALLOCATION_HOOK
+    return numAllocations;
+#else
+    return 0;
+#endif
+}
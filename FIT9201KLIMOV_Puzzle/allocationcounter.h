@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// counts heap allocations of each thread, the hook is built only by 'qmake CONFIG+=count_allocations'
+// (defines PUZZLE_COUNT_ALLOCATIONS) with glibc, else nothing is counted
+class AllocationCounter
+{
+public:
+    static bool isEnabled();
+    // allocations made by the current thread since its start
+    static quint64 count();
+};
+
+#endif // ALLOCATIONCOUNTER_H
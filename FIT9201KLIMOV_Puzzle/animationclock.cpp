@@ -0,0 +1,52 @@
+#include "animationclock.h"
+
+#include <cassert>
+#include <cmath>
+
+AnimationClock::AnimationClock(int _cycleDuration):
+    phase(0.f), cycleDuration(_cycleDuration), running(false)
+{
+    assert(cycleDuration > 0);
+    phaseTime.start();
+}
+
+void AnimationClock::start(){
+    if(running){
+        return;
+    }
+    phaseTime.start();
+    running = true;
+}
+
+void AnimationClock::stop(){
+    if(!running){
+        return;
+    }
+    phase = getPhase();
+    running = false;
+}
+
+void AnimationClock::setCycleDuration(int _cycleDuration){
+    assert(_cycleDuration > 0);
+    // keep current phase, only speed is changed
+    phase = getPhase();
+    phaseTime.start();
+    cycleDuration = _cycleDuration;
+}
+
+void AnimationClock::setPhase(float _phase){
+    phase = _phase - floor(_phase);
+    phaseTime.start();
+}
+
+float AnimationClock::getPhase()const{
+    if(!running){
+        return phase;
+    }
+    // monotonic timer is not moved by changes of system clock
+    const double current = phase + static_cast<double>(phaseTime.elapsed()) / cycleDuration;
+    const float result = static_cast<float>(current - floor(current));
+
+    assert(result >= 0.f && result <= 1.f);
+    return (result >= 1.f) ? 0.f : result;
+}
@@ -0,0 +1,32 @@
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QElapsedTimer>
+
+// continuous animation time: phase of cycle in [0, 1) is calculated from elapsed time,
+// so playback speed is not depending on how often (and how long) frames are drawn
+class AnimationClock
+{
+public:
+    explicit AnimationClock(int _cycleDuration);
+
+    void start();
+    void stop();
+    bool isRunning()const {return running;}
+
+    // duration of whole cycle in milliseconds
+    void setCycleDuration(int _cycleDuration);
+    int getCycleDuration()const {return cycleDuration;}
+
+    // move clock to phase 'phase' (used when dial is moved by user)
+    void setPhase(float phase);
+    // phase of cycle in [0, 1) on current time
+    float getPhase()const;
+private:
+    QElapsedTimer phaseTime;   // monotonic time since 'phase' was fixed
+    float phase;
+    int cycleDuration;
+    bool running;
+};
+
+#endif // ANIMATIONCLOCK_H
@@ -0,0 +1,174 @@
+#include "frameprefetcher.h"
+#include "allocationcounter.h"
+
+#include <QThread>
+#include <QThreadStorage>
+#include <QColor>
+#include <QtConcurrentRun>
+
+#include <cassert>
+
+namespace{
+    // each thread of pool keeps buffers of its previous frame, they are deleted with thread
+    QThreadStorage<RenderArena*> workerArenas;
+}
+
+FramePrefetcher::FramePrefetcher(int _maxStep, int _maxStoredFrames):
+    maxStep(_maxStep), maxStoredFrames(_maxStoredFrames),
+    // one thread is left to GUI thread
+    maxJobs(qMax(1, QThread::idealThreadCount() - 1)), workerAllocations(0)
+{
+    assert(maxStep > 0);
+}
+
+FramePrefetcher::~FramePrefetcher(){
+    invalidate(true);
+    qDeleteAll(freeFrames);
+}
+
+bool FramePrefetcher::renderFrame(PuzzleRenderer renderer, QSize areaSize, Frame* frame, int maxStep,
+                                  QSharedPointer<QAtomicInt> cancelled){
+    const quint64 allocationsBefore = AllocationCounter::count();
+    if(!workerArenas.hasLocalData()){
+        workerArenas.setLocalData(new RenderArena());
+    }
+    // image of dropped frame is reused if window size is not changed
+    if(frame->image.size() != areaSize){
+        frame->image = QImage(areaSize, QImage::Format_RGB888);
+    }
+    frame->image.fill(QColor(Qt::white).rgb());
+    const bool isRendered = renderer.render(static_cast<float>(frame->step) / maxStep, frame->image, frame->positions,
+                                            *workerArenas.localData(), cancelled.data());
+    frame->allocations = AllocationCounter::count() - allocationsBefore;
+    return isRendered;
+}
+
+FramePrefetcher::Frame* FramePrefetcher::takeFrame(){
+    if(freeFrames.isEmpty()){
+        Frame* frame = new Frame();
+        frame->allocations = 0;
+        return frame;
+    }
+    return freeFrames.takeLast();
+}
+
+void FramePrefetcher::releaseFrame(Frame* frame){
+    // frames of all jobs and store are enough to be reused
+    if(freeFrames.size() >= maxJobs + maxStoredFrames){
+        delete frame;
+        return;
+    }
+    freeFrames.append(frame);
+}
+
+void FramePrefetcher::prefetch(const PuzzleRenderer& renderer, const QSize& areaSize, int currentStep,
+                               const QVector<int>& steps){
+    collectFinished();
+
+    // prediction is changed: cancel frames which are not needed anymore
+    for(QList<Job>::iterator job = jobs.begin(); job != jobs.end(); ++job){
+        if(!steps.contains(job->frame->step)){
+            job->cancelled->fetchAndStoreOrdered(1);
+        }
+    }
+    foreach(const int step, steps){
+        if(jobs.size() >= maxJobs){
+            break;
+        }
+        assert(step >= 0 && step <= maxStep);
+        if(frames.contains(step)){
+            continue;
+        }
+        bool isRendering = false;
+        foreach(const Job& job, jobs){
+            isRendering = isRendering || job.frame->step == step;
+        }
+        if(isRendering){
+            continue;
+        }
+        Job job;
+        job.frame = takeFrame();
+        job.frame->step = step;
+        job.cancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+        job.future = QtConcurrent::run(&FramePrefetcher::renderFrame, renderer, areaSize, job.frame, maxStep,
+                                       job.cancelled);
+        jobs.append(job);
+    }
+    // frame of current position is kept while scrubbing is fast
+    dropFarFrames(currentStep);
+}
+
+void FramePrefetcher::invalidate(bool waitForCancel){
+    // renderer copies of jobs share models, so cancelled jobs are kept until they finish
+    foreach(const Job& job, jobs){
+        job.cancelled->fetchAndStoreOrdered(1);
+        cancelledJobs.append(job);
+    }
+    jobs.clear();
+    foreach(Frame* frame, frames){
+        releaseFrame(frame);
+    }
+    frames.clear();
+    if(waitForCancel){
+        foreach(const Job& job, cancelledJobs){
+            QFuture<bool> future = job.future;
+            future.waitForFinished();
+        }
+    }
+    dropFinishedCancelled();
+}
+
+void FramePrefetcher::dropFinishedCancelled(){
+    for(QList<Job>::iterator job = cancelledJobs.begin(); job != cancelledJobs.end(); ){
+        if(job->future.isFinished()){
+            workerAllocations += job->frame->allocations;
+            releaseFrame(job->frame);
+            job = cancelledJobs.erase(job);
+        }
+        else{
+            ++job;
+        }
+    }
+}
+
+bool FramePrefetcher::findFrame(int step, QImage& image, QVector<PiecePosition>& positions){
+    collectFinished();
+    QMap<int, Frame*>::const_iterator frame = frames.constFind(step);
+    if(frame == frames.constEnd()){
+        return false;
+    }
+    image = (*frame)->image;
+    positions = (*frame)->positions;
+    return true;
+}
+
+void FramePrefetcher::collectFinished(){
+    dropFinishedCancelled();
+    for(QList<Job>::iterator job = jobs.begin(); job != jobs.end(); ){
+        if(!job->future.isFinished()){
+            ++job;
+            continue;
+        }
+        workerAllocations += job->frame->allocations;
+        if(job->future.result() && *job->cancelled == 0){
+            frames.insert(job->frame->step, job->frame);
+        }
+        else{
+            releaseFrame(job->frame);
+        }
+        job = jobs.erase(job);
+    }
+}
+
+void FramePrefetcher::dropFarFrames(int step){
+    while(frames.size() > maxStoredFrames){
+        QMap<int, Frame*>::iterator farthest = frames.begin();
+        for(QMap<int, Frame*>::iterator frame = frames.begin(); frame != frames.end(); ++frame){
+            if(qAbs(frame.key() - step) > qAbs(farthest.key() - step)){
+                farthest = frame;
+            }
+        }
+        releaseFrame(farthest.value());
+        frames.erase(farthest);
+    }
+}
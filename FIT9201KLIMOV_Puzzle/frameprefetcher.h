@@ -0,0 +1,67 @@
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <QImage>
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include <QFuture>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+#include "puzzlerenderer.h"
+
+// renders predicted frames on idle threads of pool and keeps them in bounded store,
+// frames are identified by step of progress [0, maxStep]
+class FramePrefetcher
+{
+public:
+    FramePrefetcher(int _maxStep, int _maxStoredFrames);
+    ~FramePrefetcher();
+
+    // frames are rendered by 'renderer' on area of 'areaSize' for 'steps', the nearest first;
+    // rendering of frames out of 'steps' is cancelled, stored frames far from 'currentStep' are dropped
+    void prefetch(const PuzzleRenderer& renderer, const QSize& areaSize, int currentStep, const QVector<int>& steps);
+    // all stored frames are dropped and rendering is cancelled,
+    // 'waitForCancel' waits for all jobs ever cancelled, it is needed before models used by renderer are changed
+    void invalidate(bool waitForCancel);
+    // move rendered frames to store, returns true if 'step' is ready
+    bool findFrame(int step, QImage& image, QVector<PiecePosition>& positions);
+    // heap allocations of finished jobs on threads of pool, see AllocationCounter
+    quint64 getWorkerAllocations()const {return workerAllocations;}
+private:
+    // image and positions of frame are reused by next jobs after frame is dropped
+    struct Frame{
+        int step;
+        QImage image;
+        QVector<PiecePosition> positions;
+        quint64 allocations;
+    };
+    struct Job{
+        QSharedPointer<QAtomicInt> cancelled;
+        // frame is written only by job until it is finished
+        Frame* frame;
+        QFuture<bool> future;
+    };
+    static bool renderFrame(PuzzleRenderer renderer, QSize areaSize, Frame* frame, int maxStep,
+                            QSharedPointer<QAtomicInt> cancelled);
+    // frame from free list if there is one
+    Frame* takeFrame();
+    void releaseFrame(Frame* frame);
+    void collectFinished();
+    void dropFinishedCancelled();
+    // keep not more than 'maxStoredFrames' frames, the nearest to 'step'
+    void dropFarFrames(int step);
+
+    int maxStep;
+    int maxStoredFrames;
+    int maxJobs;
+    QMap<int, Frame*> frames;
+    QList<Job> jobs;
+    // jobs dropped by invalidate() which may still read models and write their frames
+    QList<Job> cancelledJobs;
+    QList<Frame*> freeFrames;
+    quint64 workerAllocations;
+};
+
+#endif // FRAMEPREFETCHER_H
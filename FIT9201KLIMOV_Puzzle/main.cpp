@@ -1,10 +1,101 @@
 #include <QtGui/QApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QTime>
 #include "puzzlewindow.h"
+#include "puzzlescene.h"
+#include "tracereplayer.h"
+#include "allocationcounter.h"
 
+#include <cstring>
+
+namespace{
+    // drive puzzle scene by trace without window and print frame times
+    int replay(const QString& fileName, bool realTime, bool isPrefetched, PuzzleTexture::Format textureFormat){
+        QTextStream out(stdout);
+        TraceReplayer replayer;
+        if(!replayer.open(fileName)){
+            out << "Can not read trace " << fileName << ": " << replayer.getError() << endl;
+            return 1;
+        }
+        TriangleAnimationModel::setRandomSeed(replayer.getSeed());
+        PuzzleScene scene;
+        if(!scene.setPuzzle(PuzzleScene::loadPuzzle(textureFormat))){
+            out << "Can not load puzzle " << PuzzleScene::getPuzzleFile() << endl;
+            return 1;
+        }
+        // prefetched frames depend on timing of threads, so they are used only if they are asked
+        scene.setPrefetchEnabled(isPrefetched);
+        const FrameStats stats = replayer.run(scene, realTime);
+        out << "frames: " << stats.frames << " total: " << stats.total << " us"
+            << " min: " << stats.min << " us avg: " << stats.average << " us"
+            << " p95: " << stats.percentile95 << " us max: " << stats.max << " us" << endl;
+        if(AllocationCounter::isEnabled()){
+            out << "allocations: " << stats.allocations
+                << " steady state allocations: " << stats.steadyStateAllocations << endl;
+            if(isPrefetched){
+                out << "prefetch allocations: " << stats.prefetchAllocations << endl;
+            }
+            // steady state drawing must reuse buffers of previous frames
+            if(stats.steadyStateAllocations != 0){
+                out << "Steady state frames allocate memory" << endl;
+                return 2;
+            }
+        }
+        return 0;
+    }
+}
+
+// FIT9201KLIMOV_puzzle [--format <name>] [--cycle <ms>] [--record <trace>] | [--replay <trace> [--realtime] [--prefetch]]
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    PuzzleWindow w;
+    // replay creates no widgets, so it runs without display
+    bool isReplay = false;
+    for(int i = 1; i < argc; ++i){
+        isReplay = isReplay || strcmp(argv[i], "--replay") == 0;
+    }
+    QApplication a(argc, argv, !isReplay);
+    // cache of decoded puzzle is kept in directory of application
+    a.setOrganizationName("NSU");
+    a.setApplicationName("FIT9201KLIMOV_puzzle");
+    const QStringList arguments = a.arguments();
+
+    // internal format of texture, see PuzzleTexture::parseFormat for names
+    PuzzleTexture::Format textureFormat = PuzzleTexture::Format_Auto;
+    const int formatIndex = arguments.indexOf("--format");
+    if(formatIndex > 0 && formatIndex + 1 < arguments.size()){
+        if(!PuzzleTexture::parseFormat(arguments[formatIndex + 1], textureFormat)){
+            QTextStream(stdout) << "Texture format must be one of auto, lossy, argb32, rgb565, indexed8, yuv420" << endl;
+            return 1;
+        }
+    }
+
+    const int replayIndex = arguments.indexOf("--replay");
+    if(replayIndex > 0 && replayIndex + 1 < arguments.size()){
+        return replay(arguments[replayIndex + 1], arguments.contains("--realtime"), arguments.contains("--prefetch"),
+                      textureFormat);
+    }
+
+    QTime midnight(0, 0, 0);
+    const uint seed = midnight.secsTo(QTime::currentTime());
+    TriangleAnimationModel::setRandomSeed(seed);
+
+    PuzzleWindow w(textureFormat);
+    // duration of whole disassembling and assembling cycle of animation
+    const int cycleIndex = arguments.indexOf("--cycle");
+    if(cycleIndex > 0 && cycleIndex + 1 < arguments.size()){
+        bool isNumber = false;
+        const int cycleDuration = arguments[cycleIndex + 1].toInt(&isNumber);
+        if(!isNumber || cycleDuration <= 0){
+            QTextStream(stdout) << "Cycle duration must be positive number of milliseconds" << endl;
+            return 1;
+        }
+        w.setCycleDuration(cycleDuration);
+    }
+    const int recordIndex = arguments.indexOf("--record");
+    if(recordIndex > 0 && recordIndex + 1 < arguments.size()){
+        w.startRecording(arguments[recordIndex + 1], seed);
+    }
     w.show();
     a.installEventFilter(&w);
     return a.exec();
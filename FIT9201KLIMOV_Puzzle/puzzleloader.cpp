@@ -0,0 +1,167 @@
+#include "puzzleloader.h"
+
+#include <QImage>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+#include <cassert>
+
+namespace{
+    static const quint32 CACHE_MAGIC = 0x505a4c43; // "PZLC"
+    static const quint32 CACHE_VERSION = 3;  // 3: exact Indexed8 palette, no RGB565 in auto mode
+}
+
+PuzzleData PuzzleLoader::load(const QString& fileName, int density, PuzzleTexture::Format format, const QString& cacheDir){
+    PuzzleData data;
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        return data;
+    }
+    const QByteArray content = file.readAll();
+
+    QString cachePath;
+    if(!cacheDir.isEmpty()){
+        cachePath = cacheFileName(cacheDir, QCryptographicHash::hash(content, QCryptographicHash::Md5), density, format);
+        if(readCache(cachePath, data)){
+            data.models = makeModels(data.triangles);
+            return data;
+        }
+    }
+
+    QImage image;
+    if(!image.loadFromData(content)){
+        return data;
+    }
+    data.texture = PuzzleTexture(image, format);
+    data.triangles = tessellate(data.texture.width(), data.texture.height(), density);
+
+    if(!cachePath.isEmpty()){
+        writeCache(cachePath, data);
+    }
+    data.models = makeModels(data.triangles);
+    return data;
+}
+
+QVector<QSharedPointer<TriangleAnimationModel> > PuzzleLoader::makeModels(const QVector<QPointF>& triangles){
+    assert(triangles.size() % 3 == 0);
+    QVector<QSharedPointer<TriangleAnimationModel> > models;
+    models.reserve(triangles.size() / 3);
+    for(int i = 0; i + 2 < triangles.size(); i += 3){
+        models.append(QSharedPointer<TriangleAnimationModel>(new TriangleAnimationModel
+            (triangles[i], triangles[i + 1], triangles[i + 2])));
+    }
+    return models;
+}
+
+QVector<QPointF> PuzzleLoader::tessellate(int width, int height, int density){
+    QVector<QPointF> triangles;
+
+    const int step = width / density;
+    assert(step > 0);
+    /* calculate all such triangles
+         |\
+         | \
+         |__\
+     */
+    for(int i = 0; i<width; i += step){
+        for(int j = 0; j<height; j += step){
+            triangles.append(QPointF(static_cast<float>(i) / width,
+                                     static_cast<float>(j) / height));
+            triangles.append(QPointF(static_cast<float>(width - step > step ? i + step : width) / width,
+                                     static_cast<float>(j) / height));
+            triangles.append(QPointF(static_cast<float>(i) / width,
+                                     static_cast<float>(qMin(j + step, height)) / height));
+        }
+    }
+    /* calculate all such triangles
+       ____
+       \  |
+        \ |
+         \|
+     */
+    for(int i = 0; i<width; i += step){
+        for(int j = 0; j<height; j += step){
+            triangles.append(QPointF(static_cast<float>(i) / width,
+                                     static_cast<float>(height - step > step ? j + step : height) / height));
+            triangles.append(QPointF(static_cast<float>(width - step > step ? i + step : width) / width,
+                                     static_cast<float>(j) / height));
+            triangles.append(QPointF(static_cast<float>(width - step > step ? i + step : width) / width,
+                                     static_cast<float>(height - step > step ? j + step : height) / height));
+        }
+    }
+    return triangles;
+}
+
+QString PuzzleLoader::cacheFileName(const QString& cacheDir, const QByteArray& hash, int density, PuzzleTexture::Format format){
+    return QDir(cacheDir).filePath(QString("%1_%2_%3.cache").arg(QString(hash.toHex())).arg(density).arg(static_cast<int>(format)));
+}
+
+bool PuzzleLoader::readCache(const QString& path, PuzzleData& data){
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION){
+        return false;
+    }
+
+    PuzzleTexture texture;
+    if(!texture.read(in)){
+        return false;
+    }
+    QVector<QPointF> triangles;
+    in >> triangles;
+    if(in.status() != QDataStream::Ok || triangles.isEmpty() || triangles.size() % 3 != 0){
+        return false;
+    }
+    // models assert texture coordinates
+    foreach(const QPointF& point, triangles){
+        if(point.x() < 0. || point.x() > 1. || point.y() < 0. || point.y() > 1.){
+            return false;
+        }
+    }
+
+    data.texture = texture;
+    data.triangles = triangles;
+    return true;
+}
+
+void PuzzleLoader::writeCache(const QString& path, const PuzzleData& data){
+    if(!QDir().mkpath(QFileInfo(path).absolutePath())){
+        return;
+    }
+    // write to unique temporary file first, so other instance never reads half of cache
+    // and concurrent writers do not mix their files
+    QTemporaryFile file(path + ".XXXXXX");
+    if(!file.open()){
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    out << CACHE_MAGIC << CACHE_VERSION;
+    data.texture.write(out);
+    out << data.triangles;
+    file.close();
+
+    // failed temporary file is removed by its destructor
+    if(out.status() != QDataStream::Ok){
+        return;
+    }
+    QFile::remove(path);
+    if(file.rename(path)){
+        // name of file is already 'path', it must not be removed
+        file.setAutoRemove(false);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef PUZZLELOADER_H
+#define PUZZLELOADER_H
+
+#include <QVector>
+#include <QPointF>
+#include <QString>
+#include <QByteArray>
+#include <QSharedPointer>
+
+#include "puzzletexture.h"
+#include "triangleanimationmodel.h"
+
+// result of loading: texture in sampling layout and its splitting on triangles
+struct PuzzleData{
+    PuzzleTexture texture;
+    // apexes of texture triangles in [0, 1] coordinates, three points per triangle
+    QVector<QPointF> triangles;
+    // animation models of triangles, made by loading thread too
+    QVector<QSharedPointer<TriangleAnimationModel> > models;
+};
+
+// loads puzzle out of GUI thread, decoded texture and triangles are kept
+// in cache directory, key is hash of image file, density and texture format
+class PuzzleLoader
+{
+public:
+    // 'cacheDir' may be empty, then cache is not used
+    static PuzzleData load(const QString& fileName, int density, PuzzleTexture::Format format, const QString& cacheDir);
+    // split image 'width' x 'height' on 'density' x 'density' squares, two triangles in each
+    static QVector<QPointF> tessellate(int width, int height, int density);
+    // animation model for each three apexes of 'triangles'
+    static QVector<QSharedPointer<TriangleAnimationModel> > makeModels(const QVector<QPointF>& triangles);
+private:
+    static QString cacheFileName(const QString& cacheDir, const QByteArray& hash, int density, PuzzleTexture::Format format);
+    static bool readCache(const QString& path, PuzzleData& data);
+    static void writeCache(const QString& path, const PuzzleData& data);
+};
+
+#endif // PUZZLELOADER_H
@@ -0,0 +1,745 @@
+#include "puzzlerenderer.h"
+
+#include <QtAlgorithms>
+
+#include <cassert>
+#include <cmath>
+#include <climits>
+
+namespace{
+    static const int DEADLINE = 100000;
+    static const float OFFSET_FROM_MODEL_COORDINAT = 0.75f;
+    static const float PI = 3.14159265358979f;
+    static const QRgb BORDER_COLOR = qRgb(0, 0, 0);
+    static const QRgb BACKGROUND_COLOR = qRgb(255, 255, 255);
+
+    bool edgeStartsBefore(const ScanlineEdge& first, const ScanlineEdge& second){
+        return first.yTop < second.yTop;
+    }
+
+    // two edges of piece are neighbours after sorting, left and right of them are found on drawing
+    bool edgeDrawsBefore(const ScanlineEdge& first, const ScanlineEdge& second){
+        return first.piece < second.piece;
+    }
+
+    // X coordinate of edge on row 'y', it does not depend on rows passed before
+    int edgeX(const ScanlineEdge& edge, int y){
+        return qRound(edge.x + (y - edge.yTop) * edge.dxdy);
+    }
+
+    bool rectStartsBefore(const QRect& first, const QRect& second){
+        return first.left() < second.left();
+    }
+
+    // screen rect covered by piece on 'position' with its border
+    QRect pieceBounds(const PiecePosition& position){
+        const int left = qMin(position.first.x(), qMin(position.second.x(), position.third.x()));
+        const int right = qMax(position.first.x(), qMax(position.second.x(), position.third.x()));
+        return QRect(QPoint(left, position.first.y()), QPoint(right, position.third.y()));
+    }
+
+    // merged parts [left, right] of row 'y' covered by 'dirtyRects' ordered by left side
+    void collectRowSpans(const QVector<QRect>& dirtyRects, int y, QVector<RowSpan>& rowSpans){
+        rowSpans.resize(0);
+        for(int i = 0; i < dirtyRects.size(); ++i){
+            const QRect& rect = dirtyRects[i];
+            if(rect.top() > y || rect.bottom() < y){
+                continue;
+            }
+            if(!rowSpans.isEmpty() && rect.left() <= rowSpans.last().right + 1){
+                rowSpans.last().right = qMax(rowSpans.last().right, rect.right());
+            }
+            else{
+                const RowSpan span = {rect.left(), rect.right()};
+                rowSpans.append(span);
+            }
+        }
+    }
+
+    // edge from 'top' to 'bottom' active on rows [top.y(), yEnd)
+    void addScanlineEdge(QVector<ScanlineEdge>& edges, int piece, const QPoint& top, const QPoint& bottom, int yEnd){
+        if(yEnd <= top.y()){
+            return;
+        }
+        ScanlineEdge edge;
+        edge.piece = piece;
+        edge.yTop = top.y();
+        edge.yEnd = yEnd;
+        edge.x = top.x();
+        const int dy = bottom.y() - top.y();
+        edge.dxdy = (dy == 0) ? 0.f : static_cast<float>(bottom.x() - top.x()) / dy;
+        edges.append(edge);
+    }
+
+    // for each piece two edges are active on every row
+    // [first, second) row edge 1_2, [second, third] edge 2_3, [first, third] edge 1_3
+    void addPieceEdges(QVector<ScanlineEdge>& edges, int piece, const PiecePosition& position){
+        if(position.first.y() == position.third.y()){
+            // flat piece is one row from the leftmost to the rightmost apex
+            const int y = position.first.y();
+            const int left = qMin(position.first.x(), qMin(position.second.x(), position.third.x()));
+            const int right = qMax(position.first.x(), qMax(position.second.x(), position.third.x()));
+            addScanlineEdge(edges, piece, QPoint(left, y), QPoint(left, y), y + 1);
+            addScanlineEdge(edges, piece, QPoint(right, y), QPoint(right, y), y + 1);
+            return;
+        }
+        addScanlineEdge(edges, piece, position.first, position.second, position.second.y());
+        addScanlineEdge(edges, piece, position.second, position.third, position.third.y() + 1);
+        addScanlineEdge(edges, piece, position.first, position.third, position.third.y() + 1);
+    }
+}
+
+bool PuzzleRenderer::RowClip::contains(const int x, const int y){
+    if(y != row){
+        collectRowSpans(*dirtyRects, y, *rowSpans);
+        row = y;
+    }
+    for(int i = 0; i < rowSpans->size(); ++i){
+        if((*rowSpans)[i].left <= x && (*rowSpans)[i].right >= x){
+            return true;
+        }
+    }
+    return false;
+}
+
+// piece is drawn on the whole target
+struct PuzzleRenderer::DrawPlot{
+    const PuzzleRenderer& renderer;
+    const PiecePosition& position;
+    QImage& target;
+
+    void border(const int x, const int y){
+        assert(0 < y && target.height() > y);
+        target.setPixel(QPoint(x, y), BORDER_COLOR);
+    }
+    void interior(const int x, const int y){
+        renderer.drawTexturePixel(x, y, position, target);
+    }
+};
+
+// piece is drawn only inside dirty rows of incremental frame
+struct PuzzleRenderer::ClippedDrawPlot{
+    const PuzzleRenderer& renderer;
+    const PiecePosition& position;
+    QImage& target;
+    RowClip& clip;
+
+    void border(const int x, const int y){
+        if(clip.contains(x, y)){
+            assert(0 < y && target.height() > y);
+            target.setPixel(QPoint(x, y), BORDER_COLOR);
+        }
+    }
+    void interior(const int x, const int y){
+        if(clip.contains(x, y)){
+            renderer.drawTexturePixel(x, y, position, target);
+        }
+    }
+};
+
+// pixels of piece are counted without drawing
+struct PuzzleRenderer::CountPlot{
+    const PuzzleRenderer& renderer;
+    const PiecePosition& position;
+    PieceCounters& counters;
+
+    void border(const int, const int){
+        counters.numPixelBorder++;
+    }
+    void interior(const int x, const int y){
+        counters.numPixelTriangle++;
+        float alphaMixVal = 1.f;
+        if(renderer.settings.isAlphaMixered){
+            renderer.sampleTexture(x, y, position, alphaMixVal);
+        }
+        //knowledge of not transporant pixels
+        const float ebs = 0.0001f;
+        if(fabs(alphaMixVal - 1.f) < ebs){
+            counters.numPixelTransparent++;
+        }
+    }
+};
+
+PuzzleRenderer::PuzzleRenderer(const PuzzleTexture& _puzzle, const QVector<QSharedPointer<TriangleAnimationModel> >& _models,
+                               const RenderSettings& _settings):
+    puzzle(_puzzle), models(_models), settings(_settings)
+{
+}
+
+PiecePosition PuzzleRenderer::calculatePiecePosition(const TriangleAnimationModel& model, const float progress,
+                                                     const int imageX, const int imageY, const QImage& target) const{
+    const Triangle<QPointF>& startPosTriangle(model.getTextureTriangle());
+    Triangle<QPointF> currentTriangle(startPosTriangle);
+    PiecePosition position;
+    // every piece moves on its own part of global progress
+    position.pieceProgress = model.getPieceProgress(progress);
+    position.currentDegree = model.getDegree() * position.pieceProgress;
+    position.imageX = imageX;
+    position.imageY = imageY;
+
+    assert(startPosTriangle.getFirst().x() >= 0.f && startPosTriangle.getFirst().x() <= 1.f);
+    assert(startPosTriangle.getFirst().y() >= 0.f && startPosTriangle.getFirst().y() <= 1.f);
+    assert(startPosTriangle.getSecond().x() >= 0.f && startPosTriangle.getSecond().x() <= 1.f);
+    assert(startPosTriangle.getSecond().y() >= 0.f && startPosTriangle.getSecond().y() <= 1.f);
+    assert(startPosTriangle.getThird().x() >= 0.f && startPosTriangle.getThird().x() <= 1.f);
+    assert(startPosTriangle.getThird().y() >= 0.f && startPosTriangle.getThird().y() <= 1.f);
+
+    position.coordinateRotateFrom = startPosTriangle.middle();
+    // rotation back to texture is the same for all pixels of piece
+    const float radian = -position.currentDegree * PI / 180.f;
+    position.rotateBackCos = cos(radian);
+    position.rotateBackSin = sin(radian);
+
+    currentTriangle.rotate(position.coordinateRotateFrom, position.currentDegree);           // rotate
+    position.curvePoint = model.getNextCurvePoint(1.f - position.pieceProgress);
+
+    assert(-0.5f <= position.curvePoint.x() && 1.5 >= position.curvePoint.x());
+    assert(-0.5f <= position.curvePoint.y() && 1.5 >= position.curvePoint.y());
+
+    currentTriangle += position.curvePoint - startPosTriangle.middle(); //shift
+
+    assert(currentTriangle.getFirst().x() >= -0.75f && currentTriangle.getFirst().x() <= 1.75f);
+    assert(currentTriangle.getFirst().y() >= -0.75f && currentTriangle.getFirst().y() <= 1.75f);
+    assert(currentTriangle.getSecond().x() >= -0.75f && currentTriangle.getSecond().x() <= 1.75f);
+    assert(currentTriangle.getSecond().y() >= -0.75f && currentTriangle.getSecond().y() <= 1.75f);
+    assert(currentTriangle.getThird().x() >= -0.75f && currentTriangle.getThird().x() <= 1.75f);
+    assert(currentTriangle.getThird().y() >= -0.75f && currentTriangle.getThird().y() <= 1.75f);
+
+    const int scaledFirstX = (currentTriangle.getFirst().x() + OFFSET_FROM_MODEL_COORDINAT) * imageX;
+    const int scaledSecondX = (currentTriangle.getSecond().x() + OFFSET_FROM_MODEL_COORDINAT) * imageX;
+    const int scaledThirdX = (currentTriangle.getThird().x() + OFFSET_FROM_MODEL_COORDINAT) * imageX;
+
+    const int scaledFirstY = (currentTriangle.getFirst().y() + OFFSET_FROM_MODEL_COORDINAT) * imageY;
+    const int scaledSecondY = (currentTriangle.getSecond().y() + OFFSET_FROM_MODEL_COORDINAT) * imageY;
+    const int scaledThirdY = (currentTriangle.getThird().y() + OFFSET_FROM_MODEL_COORDINAT) * imageY;
+
+    assert(target.width() > scaledFirstX && 0 < scaledFirstX );
+    assert(target.width() > scaledSecondX && 0 < scaledSecondX );
+    assert(target.width() > scaledThirdX && 0 < scaledThirdX );
+
+    assert(target.height() > scaledFirstY && 0 < scaledFirstY);
+    assert(target.height() > scaledSecondY && 0 < scaledSecondY);
+    assert(target.height() > scaledThirdY && 0 < scaledThirdY);
+
+    assert(scaledFirstY <= scaledSecondY );
+    assert(scaledSecondY <= scaledThirdY);
+
+    position.first = QPoint(scaledFirstX, scaledFirstY);
+    position.second = QPoint(scaledSecondX, scaledSecondY);
+    position.third = QPoint(scaledThirdX, scaledThirdY);
+    return position;
+}
+
+QRgb PuzzleRenderer::sampleTexture(const int x, const int y, const PiecePosition& position, float& alphaMixVal) const{
+    // rotation and shifting current point to point in model coordinates
+    const float shiftedX = static_cast<float>(x) / position.imageX - OFFSET_FROM_MODEL_COORDINAT - position.curvePoint.x();
+    const float shiftedY = static_cast<float>(y) / position.imageY - OFFSET_FROM_MODEL_COORDINAT - position.curvePoint.y();
+    const float textureX = shiftedX * position.rotateBackCos - shiftedY * position.rotateBackSin
+            + position.coordinateRotateFrom.x();
+    const float textureY = shiftedX * position.rotateBackSin + shiftedY * position.rotateBackCos
+            + position.coordinateRotateFrom.y();
+
+    // normalizing coordinates if there is imprecisions of calculations (< 0.f or > 1.f)
+    float normX = (0.f > textureX) ? 0.f : textureX;
+    normX = (1.f < normX) ? 1.f : normX;
+    float normY = (0.f > textureY) ? 0.f : textureY;
+    normY = (1.f < normY) ? 1.f : normY;
+
+    QRgb color;
+    if(settings.isFiltered){
+        int alpha = 0;
+        color = makeFilter(QPointF(normX, normY), alpha);
+        alphaMixVal = (settings.isAlphaMixered ? static_cast<float>(alpha) / 255 : 1.f);
+    }
+    else{
+        color = puzzle.pixel(QPoint(normX * (puzzle.width() - 1) + 0.5f,
+                                    normY * (puzzle.height() - 1) + 0.5f));
+        // use alphaMix or not
+        alphaMixVal = (settings.isAlphaMixered ? static_cast<float>(qAlpha(color)) / 255 : 1.f);
+    }
+    return color;
+}
+
+void PuzzleRenderer::drawTexturePixel(const int x, const int y, const PiecePosition& position, QImage& target) const{
+    float alphaMixVal = 0.f;
+    const QRgb color = sampleTexture(x, y, position, alphaMixVal);
+
+    assert(0 < y && target.height() > y);
+
+    const QRgb background = target.pixel(x, y);
+    target.setPixel(QPoint(x, y),
+            qRgb((1 - alphaMixVal) * qRed(background) + alphaMixVal * qRed(color),
+                 (1 - alphaMixVal) * qGreen(background) + alphaMixVal * qGreen(color),
+                 (1 - alphaMixVal) * qBlue(background) + alphaMixVal * qBlue(color)));
+}
+
+void PuzzleRenderer::calculateStatistics(const PiecePosition& position, int& numPixelTriangle,
+                                         int& numPixelBorder, int& numPixelTransparent) const{
+    if(!settings.isScanlineRendered){
+        // pixels of Bresenham lines and fillings between them, as they are drawn by renderPieces
+        PieceCounters counters = {0, 0, 0};
+        CountPlot plot = {*this, position, counters};
+        rasterizePiece(position, plot);
+        numPixelBorder = counters.numPixelBorder;
+        numPixelTriangle = counters.numPixelTriangle + counters.numPixelBorder;
+        numPixelTransparent = counters.numPixelTransparent;
+        return;
+    }
+    // the same rows and spans as scanline rendering, but only of one piece and without drawing
+    QVector<ScanlineEdge> edges;
+    addPieceEdges(edges, 0, position);
+
+    numPixelTriangle = 0;
+    numPixelBorder = 0;
+    numPixelTransparent = 0;
+    for(int y = position.first.y(); y <= position.third.y(); ++y){
+        int leftX = INT_MAX;
+        int rightX = -1;
+        foreach(const ScanlineEdge& edge, edges){
+            if(edge.yTop <= y && edge.yEnd > y){
+                const int x = edgeX(edge, y);
+                leftX = qMin(leftX, x);
+                rightX = qMax(rightX, x);
+            }
+        }
+        if(rightX < leftX){
+            continue;
+        }
+        if(y == position.first.y() || y == position.third.y()){
+            numPixelBorder += rightX - leftX + 1;
+            continue;
+        }
+        numPixelBorder += (rightX != leftX) ? 2 : 1;
+        const int numInterior = qMax(0, rightX - leftX - 1);
+        numPixelTriangle += numInterior;
+        if(!settings.isAlphaMixered){
+            // without alpha mixing every pixel is not transparent
+            numPixelTransparent += numInterior;
+            continue;
+        }
+        for(int x = leftX + 1; x < rightX; ++x){
+            float alphaMixVal = 0.f;
+            sampleTexture(x, y, position, alphaMixVal);
+            //knowledge of not transporant pixels
+            const float ebs = 0.0001f;
+            if(fabs(alphaMixVal - 1.f) < ebs){
+                numPixelTransparent++;
+            }
+        }
+    }
+    numPixelTriangle += numPixelBorder;
+}
+
+bool PuzzleRenderer::render(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                            RenderArena& arena, const QAtomicInt* cancelled) const{
+    // incremental frames after this one use the same arena and must not grow it
+    arena.dirtyRects.reserve(models.size() * 2);
+    arena.rowSpans.reserve(models.size() * 2 + 1);
+    if(settings.isScanlineRendered){
+        return renderScanline(progress, target, positions, arena, cancelled);
+    }
+    return renderPieces(progress, target, positions, cancelled);
+}
+
+bool PuzzleRenderer::renderPieces(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                                  const QAtomicInt* cancelled) const{
+    const int scaleX = target.width() /10;
+    const int scaleY = target.height()/10;
+    const int imageX = scaleX * 4;
+    const int imageY = scaleY * 4;
+
+    assert(imageX != 0);
+    assert(imageY != 0);
+
+    positions.resize(models.size());
+    for(int k = 0; k<models.size(); ++k){
+        if(cancelled && *cancelled != 0){
+            return false;
+        }
+        positions[k] = calculatePiecePosition(*models[k], progress, imageX, imageY, target);
+        DrawPlot plot = {*this, positions[k], target};
+        rasterizePiece(positions[k], plot);
+    }
+    return true;
+}
+
+template<class Plot>
+void PuzzleRenderer::rasterizePiece(const PiecePosition& position, Plot& plot) const{
+    const int scaledFirstX = position.first.x();
+    const int scaledSecondX = position.second.x();
+    const int scaledThirdX = position.third.x();
+
+    const int scaledFirstY = position.first.y();
+    const int scaledSecondY = position.second.y();
+    const int scaledThirdY = position.third.y();
+
+    int error_1_2 = abs(scaledSecondX - scaledFirstX ) - (scaledSecondY - scaledFirstY );
+    int error_1_3 = abs(scaledThirdX - scaledFirstX) - (scaledThirdY - scaledFirstY );
+
+    int nextLinePointX_1_2 = scaledFirstX;
+    int nextLinePointY_1_2 = scaledFirstY;
+
+    int nextLinePointX_1_3 = scaledFirstX;
+    int nextLinePointY_1_3 = scaledFirstY;
+
+    bool isFilled = true;
+
+    // draw lines from the top (first Y coordinate) in both directions until (second Y coordinate not achieved)
+    plot.border(scaledSecondX, scaledSecondY);
+
+    int l = 0;
+    for(l = 0; l < DEADLINE &&
+        (nextLinePointX_1_2 != scaledSecondX
+         || nextLinePointY_1_2 < scaledSecondY);++l)
+    {
+        // filling Y line
+        if((nextLinePointY_1_2 == nextLinePointY_1_3) && !isFilled){
+            const int leftX = qMin(nextLinePointX_1_2, nextLinePointX_1_3);
+            const int rightX = qMax(nextLinePointX_1_2, nextLinePointX_1_3);
+            for(int i = leftX+1; i<rightX; ++i){
+                plot.interior(i, nextLinePointY_1_2);
+            }
+            isFilled = true;
+        }
+        // draw next point at 1_2 line
+        // wait if another line is behind (Y coordinates)
+        else if(nextLinePointY_1_2 <= nextLinePointY_1_3){
+            plot.border(nextLinePointX_1_2, nextLinePointY_1_2);
+
+            int curErr = error_1_2 * 2;
+            if(curErr > -(scaledSecondY - scaledFirstY )){
+                nextLinePointX_1_2+= (scaledFirstX < scaledSecondX ? 1: -1);
+                error_1_2 -= (scaledSecondY - scaledFirstY );
+            }
+            if(curErr < abs(scaledFirstX - scaledSecondX)){
+                nextLinePointY_1_2++;
+                error_1_2 += abs(scaledFirstX - scaledSecondX);
+                isFilled = false;
+            }
+        }
+        // draw next point at 1_3 line
+        // wait if another line is behind (Y coordinates)
+        else if(nextLinePointY_1_3 <= nextLinePointY_1_2){
+            plot.border(nextLinePointX_1_3, nextLinePointY_1_3);
+
+            int curErr = error_1_3 * 2;
+            if(curErr > -( scaledThirdY - scaledFirstY )){
+                nextLinePointX_1_3 += (scaledFirstX < scaledThirdX ? 1: -1);
+                error_1_3 -= (scaledThirdY - scaledFirstY );
+            }
+            if(curErr < abs(scaledFirstX - scaledThirdX )){
+                nextLinePointY_1_3++;
+                error_1_3 += abs(scaledFirstX - scaledThirdX);
+                isFilled = false;
+            }
+        }
+        else{
+            assert(false && "State of rasterization is invalid.");
+        }
+    }
+    assert(l < DEADLINE);
+    int nextLinePointX_2_3 = scaledSecondX;
+    int nextLinePointY_2_3 = scaledSecondY;
+
+    int error_2_3 = abs(scaledThirdX - scaledSecondX) - (scaledThirdY - scaledSecondY );
+
+    isFilled = true;
+
+    // continue of algorithm : draw lines from second Y coordanat to third Y coordinat and continue
+    // drawing of (1,3) - line until third apex is not achieved
+    plot.border(scaledThirdX, scaledThirdY);
+
+    for(l = 0;l<DEADLINE;++l){
+        // filling Y line
+        if((nextLinePointY_2_3 == nextLinePointY_1_3) && !isFilled){
+            const int leftX = qMin(nextLinePointX_2_3, nextLinePointX_1_3);
+            const int rightX = qMax(nextLinePointX_2_3, nextLinePointX_1_3);
+            for(int i = leftX+1 ;i<rightX;++i){
+                plot.interior(i, nextLinePointY_2_3);
+            }
+            isFilled = true;
+        }
+        // draw next point at 2_3 line
+        // wait if another line is behind (Y coordinates)
+        else if(nextLinePointY_2_3 <= nextLinePointY_1_3 && (nextLinePointX_2_3 != scaledThirdX || nextLinePointY_2_3 < scaledThirdY)){
+            plot.border(nextLinePointX_2_3, nextLinePointY_2_3);
+
+            int curErr = error_2_3 * 2;
+            if(curErr > -(scaledThirdY - scaledSecondY )){
+                nextLinePointX_2_3+= (scaledSecondX < scaledThirdX ? 1: -1);
+                error_2_3 -= (scaledThirdY - scaledSecondY );
+            }
+            if(curErr < abs(scaledSecondX - scaledThirdX)){
+                nextLinePointY_2_3++;
+                error_2_3 += abs(scaledSecondX - scaledThirdX);
+                isFilled = false;
+            }
+        }
+        // draw next point at 1_3 line
+        // wait if another line is behind (Y coordinates)
+        else if(nextLinePointY_1_3 <= nextLinePointY_2_3 && (nextLinePointX_1_3 != scaledThirdX || nextLinePointY_1_3 < scaledThirdY)){
+            plot.border(nextLinePointX_1_3, nextLinePointY_1_3);
+
+            int curErr = error_1_3 * 2;
+            if(curErr > -( scaledThirdY - scaledFirstY )){
+                nextLinePointX_1_3 += (scaledFirstX < scaledThirdX ? 1: -1);
+                error_1_3 -= (scaledThirdY - scaledFirstY );
+            }
+            if(curErr < abs(scaledFirstX - scaledThirdX )){
+                nextLinePointY_1_3++;
+                error_1_3 += abs(scaledFirstX - scaledThirdX);
+                isFilled = false;
+            }
+        }
+        else{
+            break;
+        }
+    }
+    assert(l < DEADLINE);
+}
+
+bool PuzzleRenderer::renderScanline(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                                    RenderArena& arena, const QAtomicInt* cancelled) const{
+    const int scaleX = target.width() /10;
+    const int scaleY = target.height()/10;
+    const int imageX = scaleX * 4;
+    const int imageY = scaleY * 4;
+
+    assert(imageX != 0);
+    assert(imageY != 0);
+
+    // global edge table of all pieces,
+    // it is kept in arena between frames, reserve() keeps its memory on shrinking
+    QVector<ScanlineEdge>& edges = arena.edges;
+    edges.reserve(models.size() * 3);
+    edges.resize(0);
+    positions.resize(models.size());
+    for(int k = 0; k<models.size(); ++k){
+        positions[k] = calculatePiecePosition(*models[k], progress, imageX, imageY, target);
+        addPieceEdges(edges, k, positions[k]);
+    }
+    qSort(edges.begin(), edges.end(), edgeStartsBefore);
+
+    return sweepEdges(positions, arena, false, target, cancelled);
+}
+
+bool PuzzleRenderer::renderChanged(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                                   RenderArena& arena) const{
+    if(positions.isEmpty() || positions.size() != models.size()){
+        return false;
+    }
+    const int imageX = target.width() / 10 * 4;
+    const int imageY = target.height() / 10 * 4;
+    if(positions.first().imageX != imageX || positions.first().imageY != imageY){
+        return false;
+    }
+
+    // old and new places of moved pieces, resting pieces keep their positions
+    QVector<QRect>& dirtyRects = arena.dirtyRects;
+    dirtyRects.reserve(models.size() * 2);
+    dirtyRects.resize(0);
+    for(int k = 0; k<models.size(); ++k){
+        PiecePosition& position = positions[k];
+        if(models[k]->getPieceProgress(progress) == position.pieceProgress){
+            continue;
+        }
+        dirtyRects.append(pieceBounds(position));
+        position = calculatePiecePosition(*models[k], progress, imageX, imageY, target);
+        dirtyRects.append(pieceBounds(position));
+    }
+    if(dirtyRects.isEmpty()){
+        return true;
+    }
+    qSort(dirtyRects.begin(), dirtyRects.end(), rectStartsBefore);
+
+    if(!settings.isScanlineRendered){
+        redrawDirtyPieces(positions, arena, target);
+        return true;
+    }
+    // resting pieces under dirty rects are drawn again in their order over cleared background,
+    // spans of redrawn rows are the same as spans of full scanline rendering
+    QVector<ScanlineEdge>& edges = arena.edges;
+    edges.reserve(models.size() * 3);
+    edges.resize(0);
+    for(int k = 0; k<models.size(); ++k){
+        const QRect bounds = pieceBounds(positions[k]);
+        for(int i = 0; i < dirtyRects.size(); ++i){
+            if(bounds.intersects(dirtyRects[i])){
+                addPieceEdges(edges, k, positions[k]);
+                break;
+            }
+        }
+    }
+    qSort(edges.begin(), edges.end(), edgeStartsBefore);
+
+    return sweepEdges(positions, arena, true, target, 0);
+}
+
+void PuzzleRenderer::redrawDirtyPieces(const QVector<PiecePosition>& positions, RenderArena& arena, QImage& target) const{
+    const QVector<QRect>& dirtyRects = arena.dirtyRects;
+    QVector<RowSpan>& rowSpans = arena.rowSpans;
+    rowSpans.reserve(models.size() * 2 + 1);
+
+    int firstRow = INT_MAX;
+    int lastRow = INT_MIN;
+    for(int i = 0; i < dirtyRects.size(); ++i){
+        firstRow = qMin(firstRow, dirtyRects[i].top());
+        lastRow = qMax(lastRow, dirtyRects[i].bottom());
+    }
+    for(int y = firstRow; y <= lastRow; ++y){
+        collectRowSpans(dirtyRects, y, rowSpans);
+        for(int i = 0; i < rowSpans.size(); ++i){
+            for(int x = rowSpans[i].left; x <= rowSpans[i].right; ++x){
+                target.setPixel(QPoint(x, y), BACKGROUND_COLOR);
+            }
+        }
+    }
+
+    // pieces under dirty rects are drawn again in their order, Bresenham lines do not leave bounds of piece
+    RowClip clip = {&dirtyRects, &rowSpans, INT_MIN};
+    for(int k = 0; k<models.size(); ++k){
+        const QRect bounds = pieceBounds(positions[k]);
+        for(int i = 0; i < dirtyRects.size(); ++i){
+            if(bounds.intersects(dirtyRects[i])){
+                ClippedDrawPlot plot = {*this, positions[k], target, clip};
+                rasterizePiece(positions[k], plot);
+                break;
+            }
+        }
+    }
+}
+
+bool PuzzleRenderer::sweepEdges(const QVector<PiecePosition>& positions, RenderArena& arena, const bool isClipped,
+                                QImage& target, const QAtomicInt* cancelled) const{
+    const QVector<ScanlineEdge>& edges = arena.edges;
+    const QVector<QRect>& dirtyRects = arena.dirtyRects;
+    QVector<ScanlineEdge>& activeEdges = arena.activeEdges;
+    QVector<RowSpan>& rowSpans = arena.rowSpans;
+    activeEdges.reserve(models.size() * 3);
+    rowSpans.reserve(models.size() * 2 + 1);
+    activeEdges.resize(0);
+    rowSpans.resize(0);
+
+    int y = edges.isEmpty() ? 0 : edges.first().yTop;
+    int lastRow = INT_MAX;
+    if(isClipped){
+        int firstRow = INT_MAX;
+        lastRow = INT_MIN;
+        for(int i = 0; i < dirtyRects.size(); ++i){
+            firstRow = qMin(firstRow, dirtyRects[i].top());
+            lastRow = qMax(lastRow, dirtyRects[i].bottom());
+        }
+        y = edges.isEmpty() ? firstRow : qMin(y, firstRow);
+    }
+    else{
+        // the whole row is drawn
+        const RowSpan span = {0, target.width() - 1};
+        rowSpans.append(span);
+    }
+
+    // sweep puzzle area from top to bottom, each row is touched only once
+    int nextEdge = 0;
+    for(; isClipped ? y <= lastRow : (nextEdge < edges.size() || !activeEdges.isEmpty()); ++y){
+        int numActive = 0;
+        for(int i = 0; i < activeEdges.size(); ++i){
+            if(activeEdges[i].yEnd > y){
+                activeEdges[numActive++] = activeEdges[i];
+            }
+        }
+        activeEdges.resize(numActive);
+        while(nextEdge < edges.size() && edges[nextEdge].yTop <= y){
+            activeEdges.append(edges[nextEdge++]);
+        }
+
+        if(isClipped){
+            // dirty parts of row are cleared, dirty rects are ordered by left side
+            collectRowSpans(dirtyRects, y, rowSpans);
+            for(int i = 0; i < rowSpans.size(); ++i){
+                for(int x = rowSpans[i].left; x <= rowSpans[i].right; ++x){
+                    target.setPixel(QPoint(x, y), BACKGROUND_COLOR);
+                }
+            }
+        }
+        if(activeEdges.isEmpty() || rowSpans.isEmpty()){
+            continue;
+        }
+        if(cancelled && *cancelled != 0){
+            return false;
+        }
+        // pieces are drawn in the same order as models, so later piece covers earlier
+        qSort(activeEdges.begin(), activeEdges.end(), edgeDrawsBefore);
+
+        assert(0 < y && target.height() > y);
+        assert(activeEdges.size() % 2 == 0);
+
+        for(int i = 0; i + 1 < activeEdges.size(); i += 2){
+            assert(activeEdges[i].piece == activeEdges[i + 1].piece);
+            const PiecePosition& position = positions[activeEdges[i].piece];
+            // rows skipped out of dirty rects do not shift edges
+            const int firstX = edgeX(activeEdges[i], y);
+            const int secondX = edgeX(activeEdges[i + 1], y);
+            const int leftX = qMin(firstX, secondX);
+            const int rightX = qMax(firstX, secondX);
+
+            assert(0 < leftX && target.width() > rightX);
+
+            for(int j = 0; j < rowSpans.size(); ++j){
+                drawPieceSpan(y, leftX, rightX, position, rowSpans[j], target);
+            }
+        }
+    }
+    return true;
+}
+
+void PuzzleRenderer::drawPieceSpan(const int y, const int leftX, const int rightX, const PiecePosition& position,
+                                   const RowSpan& clip, QImage& target) const{
+    const int fromX = qMax(leftX, clip.left);
+    const int toX = qMin(rightX, clip.right);
+    // top and bottom rows of piece are border
+    const bool isBorderRow = (y == position.first.y() || y == position.third.y());
+    for(int x = fromX; x <= toX; ++x){
+        if(isBorderRow || x == leftX || x == rightX){
+            target.setPixel(QPoint(x, y), BORDER_COLOR);
+        }
+        else{
+            drawTexturePixel(x, y, position, target);
+        }
+    }
+}
+
+QRgb PuzzleRenderer::makeFilter(QPointF point2Filter, int &alpha) const{
+    float newCoordX = point2Filter.x() * (puzzle.width() - 1);
+    int roundedNewCoordX = static_cast<int>(newCoordX);
+    if(roundedNewCoordX == (puzzle.width() - 1)) {roundedNewCoordX --;}
+    float shiftX = newCoordX - roundedNewCoordX;
+
+    float newCoordY = point2Filter.y() * (puzzle.height() - 1);
+    int roundedNewCoordY = static_cast<int>(newCoordY);
+    if(roundedNewCoordY == (puzzle.height() - 1)){roundedNewCoordY--;}
+    float shiftY = newCoordY - roundedNewCoordY;
+
+    // every texel is decoded once
+    const QRgb topLeft = puzzle.pixel(roundedNewCoordX, roundedNewCoordY);
+    const QRgb topRight = puzzle.pixel(roundedNewCoordX + 1, roundedNewCoordY);
+    const QRgb bottomRight = puzzle.pixel(roundedNewCoordX + 1, roundedNewCoordY + 1);
+    const QRgb bottomLeft = puzzle.pixel(roundedNewCoordX, roundedNewCoordY + 1);
+
+    int red = qRed(topLeft) * (1 - shiftX) * (1 - shiftY) +
+              qRed(topRight) *  shiftX * (1 - shiftY) +
+              qRed(bottomRight) * shiftX * shiftY +
+              qRed(bottomLeft) * (1 - shiftX) * shiftY;
+    int green = qGreen(topLeft) * (1 - shiftX) * (1 - shiftY) +
+              qGreen(topRight) *  shiftX * (1 - shiftY) +
+              qGreen(bottomRight) * shiftX * shiftY +
+              qGreen(bottomLeft) * (1 - shiftX) * shiftY;
+    int blue = qBlue(topLeft) * (1 - shiftX) * (1 - shiftY) +
+              qBlue(topRight) *  shiftX * (1 - shiftY) +
+              qBlue(bottomRight) * shiftX * shiftY +
+              qBlue(bottomLeft) * (1 - shiftX) * shiftY;
+    alpha = qAlpha(topLeft) * (1 - shiftX) * (1 - shiftY) +
+            qAlpha(topRight) *  shiftX * (1 - shiftY) +
+            qAlpha(bottomRight) * shiftX * shiftY +
+            qAlpha(bottomLeft) * (1 - shiftX) * shiftY;
+    return qRgb(red, green, blue);
+}
+
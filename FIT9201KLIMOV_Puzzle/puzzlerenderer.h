@@ -0,0 +1,132 @@
+#ifndef PUZZLERENDERER_H
+#define PUZZLERENDERER_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+#include "triangleanimationmodel.h"
+#include "puzzletexture.h"
+
+// position of piece on puzzle area on some progress
+struct PiecePosition{
+    // progress of piece itself, piece rests while it is not changed
+    float pieceProgress;
+    QPointF curvePoint;
+    QPointF coordinateRotateFrom;
+    float currentDegree;
+    // rotation from puzzle area back to texture by -currentDegree
+    float rotateBackCos;
+    float rotateBackSin;
+    // size of picture on puzzle area
+    int imageX;
+    int imageY;
+    // apexes ordered by Y coordinate
+    QPoint first;
+    QPoint second;
+    QPoint third;
+};
+
+// edge of piece in global edge table of scanline rendering
+struct ScanlineEdge{
+    int piece;
+    int yTop;
+    int yEnd;   // first row where edge is not active
+    float x;    // X coordinate on row yTop
+    float dxdy;
+};
+
+// part [left, right] of row drawn by scanline rendering
+struct RowSpan{
+    int left;
+    int right;
+};
+
+// transient data of frame kept from frame to frame, so steady state rendering does not allocate,
+// each thread rendering frames has its own arena
+struct RenderArena{
+    QVector<ScanlineEdge> edges;
+    QVector<ScanlineEdge> activeEdges;
+    // old and new places of pieces moved since previous frame
+    QVector<QRect> dirtyRects;
+    QVector<RowSpan> rowSpans;
+};
+
+struct RenderSettings{
+    bool isFiltered;
+    bool isAlphaMixered;
+    bool isScanlineRendered;
+};
+
+// draws pieces of puzzle on some progress, models are only read,
+// so copy of renderer may be used out of GUI thread while models are not changed
+class PuzzleRenderer
+{
+public:
+    PuzzleRenderer(const PuzzleTexture& _puzzle, const QVector<QSharedPointer<TriangleAnimationModel> >& _models,
+                   const RenderSettings& _settings);
+
+    // draw all pieces on progress 'progress' over 'target' and put their positions to 'positions',
+    // returns false if 'cancelled' was set during drawing
+    bool render(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                RenderArena& arena, const QAtomicInt* cancelled = 0) const;
+    // 'target' keeps frame of 'positions': only pieces moved since it are drawn again with pieces they overlap,
+    // returns false and draws nothing if 'positions' are not of 'target' size
+    bool renderChanged(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                       RenderArena& arena) const;
+    // color of texture under pixel {x, y} of piece
+    QRgb sampleTexture(const int x, const int y, const PiecePosition& position, float& alphaMixVal) const;
+    // pixel counters of piece on 'position' by rasterization of current mode
+    void calculateStatistics(const PiecePosition& position, int& numPixelTriangle,
+                             int& numPixelBorder, int& numPixelTransparent) const;
+private:
+    PiecePosition calculatePiecePosition(const TriangleAnimationModel& model, const float progress,
+                                         const int imageX, const int imageY, const QImage& target) const;
+    // fill pixel {x, y} of piece by texture
+    void drawTexturePixel(const int x, const int y, const PiecePosition& position, QImage& target) const;
+    // pixel counters of one piece
+    struct PieceCounters{
+        int numPixelTriangle;
+        int numPixelBorder;
+        int numPixelTransparent;
+    };
+    // pieces are drawn one after another
+    bool renderPieces(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                      const QAtomicInt* cancelled) const;
+    // dirty parts of rows drawn by incremental frame, spans are collected again only when row is changed
+    struct RowClip{
+        const QVector<QRect>* dirtyRects;
+        QVector<RowSpan>* rowSpans;
+        int row;
+        bool contains(const int x, const int y);
+    };
+    // pixel policies of rasterizePiece with border(x, y) and interior(x, y),
+    // mode is chosen at compile time, so pixel loops do not check it
+    struct DrawPlot;
+    struct ClippedDrawPlot;
+    struct CountPlot;
+    // Bresenham lines of piece borders with filling between them, each pixel is passed to 'plot'
+    template<class Plot>
+    void rasterizePiece(const PiecePosition& position, Plot& plot) const;
+    // clear dirty rects of 'arena' and draw pieces over them by Bresenham rasterization
+    void redrawDirtyPieces(const QVector<PiecePosition>& positions, RenderArena& arena, QImage& target) const;
+    // all pieces are drawn by one sweep of puzzle area from top to bottom
+    bool renderScanline(const float progress, QImage& target, QVector<PiecePosition>& positions,
+                        RenderArena& arena, const QAtomicInt* cancelled) const;
+    // draw rows of edge table of 'arena', if 'isClipped' only dirty rects are cleared and drawn
+    bool sweepEdges(const QVector<PiecePosition>& positions, RenderArena& arena, const bool isClipped,
+                    QImage& target, const QAtomicInt* cancelled) const;
+    // part of piece span [leftX, rightX] on row 'y' inside 'clip'
+    void drawPieceSpan(const int y, const int leftX, const int rightX, const PiecePosition& position,
+                       const RowSpan& clip, QImage& target) const;
+    // bilinear filtaration to point 'point2Filter'
+    QRgb makeFilter(QPointF point2Filter, int& alpha) const;
+
+    PuzzleTexture puzzle;
+    QVector<QSharedPointer<TriangleAnimationModel> > models;
+    RenderSettings settings;
+};
+
+#endif // PUZZLERENDERER_H
@@ -0,0 +1,282 @@
+#include "puzzlescene.h"
+#include "allocationcounter.h"
+
+#include <QDesktopServices>
+#include <QtAlgorithms>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace{
+    static const QString PUZZLE_FILE = ":/images/puzzle.png";
+    static const int WIDTH_SETTINGS_PANEL = 110;
+    static const int NUM_SQUIERS = 4;
+    static const int MAX_DIAL = PuzzleScene::MAX_DEGREE / 2;
+    // frames rendered in advance while dial is moved by user
+    static const int NUM_PREFETCHED_FRAMES = 4;
+    static const int MAX_PREFETCHED_STORED = 16;
+    // dial is not moved by user if it was not changed for longer time
+    static const int PREDICTION_TIMEOUT = 500;
+
+    // picture is disassembled on first half of dial and assembled on second
+    float degreeToProgress(float degree){
+        if(degree > MAX_DIAL){
+            degree = MAX_DIAL - (degree - MAX_DIAL);
+        }
+        return qBound(0.f, degree / MAX_DIAL, 1.f);
+    }
+
+    // the nearest step of progress, prefetched frames are identified by it
+    int degreeToStep(float degree){
+        return qRound(degreeToProgress(degree) * MAX_DIAL);
+    }
+}
+
+PuzzleScene::PuzzleScene():
+    degree(0), hasPendingProgress(false), pendingProgress(0.f), renderedFrames(0), frameAllocations(0),
+    isPuzzleAreaActual(false), framePrefetcher(MAX_DIAL, MAX_PREFETCHED_STORED), isPrefetchEnabled(true),
+    lastDegree(0), lastDegreeTime(0)
+{
+    const RenderSettings defaultSettings = {false, false, false};
+    settings = defaultSettings;
+}
+
+PuzzleData PuzzleScene::loadPuzzle(PuzzleTexture::Format textureFormat){
+    return PuzzleLoader::load(PUZZLE_FILE, NUM_SQUIERS, textureFormat,
+                              QDesktopServices::storageLocation(QDesktopServices::CacheLocation));
+}
+
+QString PuzzleScene::getPuzzleFile(){
+    return PUZZLE_FILE;
+}
+
+QSize PuzzleScene::areaSizeOfWindow(const QSize& windowSize){
+    return QSize(windowSize.width() - WIDTH_SETTINGS_PANEL, windowSize.height());
+}
+
+bool PuzzleScene::setPuzzle(const PuzzleData& data){
+    if(data.texture.isNull() || data.models.isEmpty()){
+        return false;
+    }
+    framePrefetcher.invalidate(false);
+    puzzle = data.texture;
+    models = data.models;
+    requestProgress(degreeToProgress(degree));
+    return true;
+}
+
+void PuzzleScene::setAreaSize(const QSize& newAreaSize){
+    framePrefetcher.invalidate(false);
+    areaSize = newAreaSize;
+    setPuzzleArea();
+    if(isLoaded()){
+        renderFrame(degreeToProgress(degree));
+    }
+}
+
+void PuzzleScene::setPuzzleArea(){
+    if(puzzleArea.size() != areaSize){
+        puzzleArea = QImage(areaSize, QImage::Format_RGB888);
+    }
+    puzzleArea.fill(qRgb(255, 255, 255));
+    isPuzzleAreaActual = false;
+}
+
+void PuzzleScene::setFiltered(bool isFiltered){
+    settings.isFiltered = isFiltered;
+    redrawSettings();
+}
+
+void PuzzleScene::setAlphaMixered(bool isAlphaMixered){
+    settings.isAlphaMixered = isAlphaMixered;
+    redrawSettings();
+}
+
+void PuzzleScene::setScanlineRendered(bool isScanlineRendered){
+    settings.isScanlineRendered = isScanlineRendered;
+    redrawSettings();
+}
+
+void PuzzleScene::redrawSettings(){
+    framePrefetcher.invalidate(false);
+    setPuzzleArea();
+    requestProgress(degreeToProgress(degree));
+}
+
+bool PuzzleScene::setDegree(int newDegree, qint64 time){
+    assert(newDegree >= 0 && newDegree <= MAX_DEGREE);
+    if(newDegree == degree){
+        return false;
+    }
+    degree = newDegree;
+    requestProgress(degreeToProgress(degree));
+    prefetchFrames(time);
+    return true;
+}
+
+void PuzzleScene::setAnimationPhase(float phase, float phasePerTick){
+    const float exactDegree = phase * (MAX_DEGREE + 1);
+    degree = static_cast<int>(exactDegree) % (MAX_DEGREE + 1);
+    // animation frames are snapped to steps of progress, so frames prefetched for them are used
+    requestProgress(static_cast<float>(degreeToStep(exactDegree)) / MAX_DIAL);
+    prefetchAnimation(phase, phasePerTick);
+}
+
+void PuzzleScene::init(){
+    // curves of models are changed, prefetching threads must not read them
+    framePrefetcher.invalidate(true);
+    foreach(const QSharedPointer<TriangleAnimationModel>& model, models ){
+        model->setNewCurve();
+    }
+    degree = 0;
+    // pieces are placed on new curves, the whole frame is drawn again
+    setPuzzleArea();
+    renderFrame(0.f);
+}
+
+void PuzzleScene::setPrefetchEnabled(bool isEnabled){
+    isPrefetchEnabled = isEnabled;
+    if(!isPrefetchEnabled){
+        framePrefetcher.invalidate(true);
+    }
+}
+
+bool PuzzleScene::renderPendingFrame(){
+    if(!hasPendingProgress){
+        return false;
+    }
+    // if drawing is slower than animation, frames between are never drawn
+    hasPendingProgress = false;
+    QImage image;
+    QVector<PiecePosition> framePositions;
+    const bool isPrefetched = findPrefetchedFrame(pendingProgress, image, framePositions);
+
+    // only drawing is counted: prefetcher bookkeeping is not part of frame
+    const quint64 allocationsBefore = AllocationCounter::count();
+    if(isPrefetched){
+        showPrefetchedFrame(image, framePositions);
+    }
+    else{
+        renderFrame(pendingProgress);
+    }
+    frameAllocations = AllocationCounter::count() - allocationsBefore;
+    return true;
+}
+
+void PuzzleScene::requestProgress(float progress){
+    pendingProgress = progress;
+    hasPendingProgress = true;
+}
+
+PuzzleRenderer PuzzleScene::getRenderer()const{
+    return PuzzleRenderer(puzzle, models, settings);
+}
+
+void PuzzleScene::renderFrame(const float progress){
+    renderedFrames++;
+    const PuzzleRenderer renderer = getRenderer();
+    // puzzle area keeps previous frame, so only moved pieces are drawn again if it is possible
+    if(!isPuzzleAreaActual || !renderer.renderChanged(progress, puzzleArea, positions, renderArena)){
+        setPuzzleArea();
+        renderer.render(progress, puzzleArea, positions, renderArena);
+    }
+    isPuzzleAreaActual = true;
+    setModelsCurrentTriangles();
+}
+
+bool PuzzleScene::findPrefetchedFrame(const float progress, QImage& image, QVector<PiecePosition>& framePositions){
+    const float exactStep = progress * MAX_DIAL;
+    const int step = qRound(exactStep);
+    // only frames on dial positions are prefetched
+    const float ebs = 0.0001f;
+    if(fabs(exactStep - step) > ebs){
+        return false;
+    }
+    return framePrefetcher.findFrame(step, image, framePositions)
+            && image.size() == puzzleArea.size() && image.format() == puzzleArea.format()
+            && framePositions.size() == models.size();
+}
+
+void PuzzleScene::showPrefetchedFrame(const QImage& image, const QVector<PiecePosition>& framePositions){
+    // puzzle area would be detached on next frame if it was shared with stored frame
+    const int bytesPerLine = qMin(image.bytesPerLine(), puzzleArea.bytesPerLine());
+    for(int y = 0; y < image.height(); ++y){
+        memcpy(puzzleArea.scanLine(y), image.constScanLine(y), bytesPerLine);
+    }
+    positions.resize(framePositions.size());
+    qCopy(framePositions.constBegin(), framePositions.constEnd(), positions.begin());
+    isPuzzleAreaActual = true;
+    renderedFrames++;
+    setModelsCurrentTriangles();
+}
+
+void PuzzleScene::prefetchFrames(qint64 time){
+    const int numDegrees = MAX_DEGREE + 1;
+    // the shortest way on dial from previous value
+    int delta = degree - lastDegree;
+    if(delta > numDegrees / 2){
+        delta -= numDegrees;
+    }
+    if(delta < -numDegrees / 2){
+        delta += numDegrees;
+    }
+    const qint64 elapsed = time - lastDegreeTime;
+    lastDegreeTime = time;
+    lastDegree = degree;
+    if(!isPrefetchEnabled || delta == 0 || elapsed > PREDICTION_TIMEOUT || models.isEmpty()){
+        return;
+    }
+
+    // dial is expected to move further in the same direction with the same speed
+    QVector<int> steps;
+    for(int i = 1; i <= NUM_PREFETCHED_FRAMES; ++i){
+        const int nextDegree = ((degree + delta * i) % numDegrees + numDegrees) % numDegrees;
+        const int step = degreeToStep(nextDegree);
+        if(!steps.contains(step)){
+            steps.append(step);
+        }
+    }
+    framePrefetcher.prefetch(getRenderer(), puzzleArea.size(), degreeToStep(degree), steps);
+}
+
+void PuzzleScene::prefetchAnimation(float phase, float phasePerTick){
+    if(!isPrefetchEnabled || models.isEmpty() || phasePerTick <= 0.f){
+        return;
+    }
+    const int numDegrees = MAX_DEGREE + 1;
+    const int currentStep = degreeToStep(phase * numDegrees);
+    QVector<int> steps;
+    for(int i = 1; i <= NUM_PREFETCHED_FRAMES; ++i){
+        float nextPhase = phase + phasePerTick * i;
+        nextPhase -= floor(nextPhase);
+        const int step = degreeToStep(nextPhase * numDegrees);
+        if(step != currentStep && !steps.contains(step)){
+            steps.append(step);
+        }
+    }
+    framePrefetcher.prefetch(getRenderer(), puzzleArea.size(), currentStep, steps);
+}
+
+void PuzzleScene::setModelsCurrentTriangles(){
+    assert(positions.size() == models.size());
+    for(int k = 0; k<models.size(); ++k){
+        models[k]->setCurrentTriangle(positions[k].first, positions[k].second, positions[k].third);
+    }
+}
+
+void PuzzleScene::calculatePieceStatistics(const int k){
+    TriangleAnimationModel& model = *models[k];
+    if(model.getStatisticsFrame() == renderedFrames || k >= positions.size()){
+        return;
+    }
+    int numPixelTriangle = 0;
+    int numPixelBorder = 0;
+    int numPixelTransparent = 0;
+    getRenderer().calculateStatistics(positions[k], numPixelTriangle, numPixelBorder, numPixelTransparent);
+
+    model.setPixelBorder(numPixelBorder);
+    model.setPixelTriangle(numPixelTriangle);
+    model.setPixelTransparent(numPixelTransparent);
+    model.setStatisticsFrame(renderedFrames);
+}
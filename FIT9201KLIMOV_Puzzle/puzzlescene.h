@@ -0,0 +1,108 @@
+#ifndef PUZZLESCENE_H
+#define PUZZLESCENE_H
+
+#include <QImage>
+#include <QSize>
+#include <QVector>
+#include <QSharedPointer>
+
+#include "triangleanimationmodel.h"
+#include "puzzleloader.h"
+#include "puzzlerenderer.h"
+#include "frameprefetcher.h"
+
+// puzzle without widgets: picture, render settings, dial position and puzzle area with its last frame,
+// PuzzleWindow shows it and TraceReplayer drives it directly, so replay does not need display
+class PuzzleScene
+{
+public:
+    PuzzleScene();
+
+    // dial goes [0, MAX_DEGREE]: picture is disassembled on first half and assembled on second
+    static const int MAX_DEGREE = 360;
+
+    // decode picture of puzzle and split it on triangles, may be called out of GUI thread
+    static PuzzleData loadPuzzle(PuzzleTexture::Format textureFormat);
+    static QString getPuzzleFile();
+    // puzzle area is the window without settings panel
+    static QSize areaSizeOfWindow(const QSize& windowSize);
+
+    // returns false if 'data' was not loaded
+    bool setPuzzle(const PuzzleData& data);
+    bool isLoaded()const {return !models.isEmpty();}
+    const QVector<QSharedPointer<TriangleAnimationModel> >& getModels()const {return models;}
+
+    // puzzle area is cleared and frame is drawn at once, image is allocated again only if size is changed
+    void setAreaSize(const QSize& areaSize);
+    const QImage& getPuzzleArea()const {return puzzleArea;}
+
+    void setFiltered(bool isFiltered);
+    void setAlphaMixered(bool isAlphaMixered);
+    void setScanlineRendered(bool isScanlineRendered);
+
+    // dial moved by user, 'time' in milliseconds is used for prediction of next positions,
+    // returns false if dial is not changed
+    bool setDegree(int newDegree, qint64 time);
+    int getDegree()const {return degree;}
+    // running animation on phase [0, 1) moves dial, next tick is expected 'phasePerTick' later
+    void setAnimationPhase(float phase, float phasePerTick);
+    // pieces get new curves, frame of dial 0 is drawn at once
+    void init();
+
+    // frames are rendered in advance on other threads, disabling waits for rendering frames
+    void setPrefetchEnabled(bool isEnabled);
+    // draw last requested frame, returns false if nothing was requested
+    bool renderPendingFrame();
+    int getRenderedFrames()const {return renderedFrames;}
+    // heap allocations of calling thread made by drawing of last frame, see AllocationCounter
+    quint64 getFrameAllocations()const {return frameAllocations;}
+    // heap allocations of threads rendering frames in advance
+    quint64 getPrefetchAllocations()const {return framePrefetcher.getWorkerAllocations();}
+    // pixel counters of piece 'k' shown on hover, calculated once per frame
+    void calculatePieceStatistics(const int k);
+private:
+    // clear puzzle area, image is allocated again only if size is changed
+    void setPuzzleArea();
+    // settings are changed, frame of the same dial is drawn again on cleared area
+    void redrawSettings();
+    // only the newest progress is kept, older not drawn frames are skipped
+    void requestProgress(float progress);
+    PuzzleRenderer getRenderer()const;
+    // draw frame of 'progress' to puzzle area,
+    // only pieces moved since previous frame are drawn if puzzle area was not cleared
+    void renderFrame(const float progress);
+    // frame of 'progress' if it was rendered in advance
+    bool findPrefetchedFrame(const float progress, QImage& image, QVector<PiecePosition>& framePositions);
+    // copy prefetched frame to puzzle area, so puzzle area is never shared with prefetcher
+    void showPrefetchedFrame(const QImage& image, const QVector<PiecePosition>& framePositions);
+    // start rendering of dial positions expected after current one
+    void prefetchFrames(qint64 time);
+    // start rendering of steps expected on next ticks of running animation after 'phase'
+    void prefetchAnimation(float phase, float phasePerTick);
+    // models remember where they are drawn for hover
+    void setModelsCurrentTriangles();
+
+    PuzzleTexture puzzle;
+    QVector<QSharedPointer<TriangleAnimationModel> > models;
+    RenderSettings settings;
+    int degree;
+
+    QSize areaSize;
+    QImage puzzleArea;
+    bool hasPendingProgress;
+    float pendingProgress;
+    // positions of models on last frame
+    QVector<PiecePosition> positions;
+    RenderArena renderArena;
+    int renderedFrames;
+    quint64 frameAllocations;
+    // puzzle area keeps frame of 'positions' and may be updated incrementally
+    bool isPuzzleAreaActual;
+
+    FramePrefetcher framePrefetcher;
+    bool isPrefetchEnabled;
+    int lastDegree;
+    qint64 lastDegreeTime;
+};
+
+#endif // PUZZLESCENE_H
@@ -0,0 +1,297 @@
+#include "puzzletexture.h"
+
+#include <QSet>
+#include <QHash>
+
+#include <cassert>
+
+namespace{
+    static const int MAX_INDEXED_COLORS = 256;
+    // larger sides in cache file are treated as corrupted
+    static const int MAX_TEXTURE_SIDE = 16384;
+    // chroma of 2x2 block differing more is sharp color edge, which YUV420 blurs
+    static const int MAX_BLOCK_CHROMA_RANGE = 32;
+    // percent of sharp blocks from which RGB565 is chosen instead of YUV420
+    static const int MAX_SHARP_BLOCKS_PERCENT = 10;
+
+    int chromaBlueOf(QRgb color){
+        return ((-43 * qRed(color) - 85 * qGreen(color) + 128 * qBlue(color)) >> 8) + 128;
+    }
+
+    int chromaRedOf(QRgb color){
+        return ((128 * qRed(color) - 107 * qGreen(color) - 21 * qBlue(color)) >> 8) + 128;
+    }
+
+    int clampColor(int value){
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    int bytesPerPixel(PuzzleTexture::Format format){
+        switch(format){
+        case PuzzleTexture::Format_ARGB32:
+            return 4;
+        case PuzzleTexture::Format_RGB565:
+            return 2;
+        case PuzzleTexture::Format_Indexed8:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+}
+
+PuzzleTexture::PuzzleTexture():
+    textureFormat(Format_ARGB32), textureWidth(0), textureHeight(0)
+{
+}
+
+PuzzleTexture::PuzzleTexture(const QImage& source, Format format):
+    textureFormat(format), textureWidth(source.width()), textureHeight(source.height())
+{
+    if(textureFormat == Format_Auto || textureFormat == Format_AutoLossy){
+        textureFormat = chooseFormat(source, textureFormat == Format_AutoLossy);
+    }
+    switch(textureFormat){
+    case Format_RGB565:
+        image = source.convertToFormat(QImage::Format_RGB16);
+        break;
+    case Format_Indexed8:
+        setIndexed8(source.convertToFormat(QImage::Format_ARGB32));
+        break;
+    case Format_YUV420:
+        setYUV420(source.convertToFormat(QImage::Format_RGB32));
+        break;
+    default:
+        textureFormat = Format_ARGB32;
+        image = source.convertToFormat(QImage::Format_ARGB32);
+        break;
+    }
+}
+
+PuzzleTexture::Format PuzzleTexture::chooseFormat(const QImage& source, bool allowLossy){
+    const QImage argb = source.convertToFormat(QImage::Format_ARGB32);
+    bool isOpaque = true;
+    QSet<QRgb> distinctColors;
+    for(int y = 0; y < argb.height(); ++y){
+        const QRgb* line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        for(int x = 0; x < argb.width(); ++x){
+            isOpaque = isOpaque && (qAlpha(line[x]) == 255);
+            if(distinctColors.size() <= MAX_INDEXED_COLORS){
+                distinctColors.insert(line[x]);
+            }
+        }
+    }
+    if(distinctColors.size() <= MAX_INDEXED_COLORS){
+        return Format_Indexed8;
+    }
+    // lossy formats lose low bits of colors or chroma details, so they are used only if they are allowed
+    if(!allowLossy || !isOpaque){
+        return Format_ARGB32;
+    }
+
+    // YUV420 is smaller, but it blurs sharp color edges of drawings, RGB565 keeps them
+    int numBlocks = 0;
+    int numSharpBlocks = 0;
+    for(int y = 0; y + 1 < argb.height(); y += 2){
+        const QRgb* top = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        const QRgb* bottom = reinterpret_cast<const QRgb*>(argb.constScanLine(y + 1));
+        for(int x = 0; x + 1 < argb.width(); x += 2){
+            const QRgb block[4] = {top[x], top[x + 1], bottom[x], bottom[x + 1]};
+            int minBlue = 255, maxBlue = 0, minRed = 255, maxRed = 0;
+            for(int i = 0; i < 4; ++i){
+                minBlue = qMin(minBlue, chromaBlueOf(block[i]));
+                maxBlue = qMax(maxBlue, chromaBlueOf(block[i]));
+                minRed = qMin(minRed, chromaRedOf(block[i]));
+                maxRed = qMax(maxRed, chromaRedOf(block[i]));
+            }
+            numBlocks++;
+            if(maxBlue - minBlue > MAX_BLOCK_CHROMA_RANGE || maxRed - minRed > MAX_BLOCK_CHROMA_RANGE){
+                numSharpBlocks++;
+            }
+        }
+    }
+    return (numSharpBlocks * 100 > numBlocks * MAX_SHARP_BLOCKS_PERCENT) ? Format_RGB565 : Format_YUV420;
+}
+
+bool PuzzleTexture::parseFormat(const QString& name, Format& format){
+    static const char* const NAMES[] = {"auto", "argb32", "rgb565", "indexed8", "yuv420", "lossy"};
+    for(int i = 0; i < static_cast<int>(sizeof(NAMES) / sizeof(NAMES[0])); ++i){
+        if(name == NAMES[i]){
+            format = static_cast<Format>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PuzzleTexture::setIndexed8(const QImage& argb){
+    // palette of Qt conversion is generic with 1 bit alpha, so exact palette is made here
+    QHash<QRgb, int> indexes;
+    for(int y = 0; y < argb.height() && indexes.size() <= MAX_INDEXED_COLORS; ++y){
+        const QRgb* line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        for(int x = 0; x < argb.width() && indexes.size() <= MAX_INDEXED_COLORS; ++x){
+            if(!indexes.contains(line[x])){
+                indexes.insert(line[x], indexes.size());
+            }
+        }
+    }
+    if(indexes.size() > MAX_INDEXED_COLORS){
+        // too many colors for exact palette, Qt quantizes them
+        image = argb.convertToFormat(QImage::Format_Indexed8);
+        colors = image.colorTable();
+        return;
+    }
+    colors.resize(indexes.size());
+    for(QHash<QRgb, int>::const_iterator color = indexes.constBegin(); color != indexes.constEnd(); ++color){
+        colors[color.value()] = color.key();
+    }
+    image = QImage(argb.width(), argb.height(), QImage::Format_Indexed8);
+    image.setColorTable(colors);
+    for(int y = 0; y < argb.height(); ++y){
+        const QRgb* line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        uchar* indexLine = image.scanLine(y);
+        for(int x = 0; x < argb.width(); ++x){
+            indexLine[x] = static_cast<uchar>(indexes.value(line[x]));
+        }
+    }
+}
+
+void PuzzleTexture::setYUV420(const QImage& rgb){
+    const int chromaWidth = (textureWidth + 1) / 2;
+    const int chromaHeight = (textureHeight + 1) / 2;
+    luma.resize(textureWidth * textureHeight);
+    chromaBlue.resize(chromaWidth * chromaHeight);
+    chromaRed.resize(chromaWidth * chromaHeight);
+
+    for(int cy = 0; cy < chromaHeight; ++cy){
+        for(int cx = 0; cx < chromaWidth; ++cx){
+            int sumBlue = 0;
+            int sumRed = 0;
+            int count = 0;
+            // BT.601 full range, chroma is averaged on 2x2 block
+            for(int y = cy * 2; y < qMin(cy * 2 + 2, textureHeight); ++y){
+                const QRgb* line = reinterpret_cast<const QRgb*>(rgb.constScanLine(y));
+                for(int x = cx * 2; x < qMin(cx * 2 + 2, textureWidth); ++x){
+                    const int r = qRed(line[x]);
+                    const int g = qGreen(line[x]);
+                    const int b = qBlue(line[x]);
+                    luma[y * textureWidth + x] = static_cast<char>(clampColor((77 * r + 150 * g + 29 * b) >> 8));
+                    sumBlue += chromaBlueOf(line[x]);
+                    sumRed += chromaRedOf(line[x]);
+                    count++;
+                }
+            }
+            assert(count > 0);
+            chromaBlue[cy * chromaWidth + cx] = static_cast<char>(clampColor(sumBlue / count));
+            chromaRed[cy * chromaWidth + cx] = static_cast<char>(clampColor(sumRed / count));
+        }
+    }
+}
+
+QRgb PuzzleTexture::pixel(int x, int y)const{
+    assert(x >= 0 && x < textureWidth);
+    assert(y >= 0 && y < textureHeight);
+
+    switch(textureFormat){
+    case Format_RGB565:{
+        const quint16 value = reinterpret_cast<const quint16*>(image.constScanLine(y))[x];
+        const int r = (value >> 11) & 0x1f;
+        const int g = (value >> 5) & 0x3f;
+        const int b = value & 0x1f;
+        return qRgb((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+    }
+    case Format_Indexed8:
+        return colors[image.constScanLine(y)[x]];
+    case Format_YUV420:
+        return pixelYUV420(x, y);
+    default:
+        return reinterpret_cast<const QRgb*>(image.constScanLine(y))[x];
+    }
+}
+
+QRgb PuzzleTexture::pixelYUV420(int x, int y)const{
+    const int chromaIndex = (y / 2) * ((textureWidth + 1) / 2) + x / 2;
+    const int lumaValue = static_cast<uchar>(luma.constData()[y * textureWidth + x]);
+    const int d = static_cast<uchar>(chromaBlue.constData()[chromaIndex]) - 128;
+    const int e = static_cast<uchar>(chromaRed.constData()[chromaIndex]) - 128;
+    return qRgb(clampColor(lumaValue + ((359 * e) >> 8)),
+                clampColor(lumaValue - ((88 * d + 183 * e) >> 8)),
+                clampColor(lumaValue + ((454 * d) >> 8)));
+}
+
+void PuzzleTexture::write(QDataStream& out)const{
+    out << static_cast<quint32>(textureFormat) << static_cast<qint32>(textureWidth) << static_cast<qint32>(textureHeight);
+    if(textureFormat == Format_YUV420){
+        out << luma << chromaBlue << chromaRed;
+        return;
+    }
+    out << colors;
+    const int bytesPerLine = textureWidth * bytesPerPixel(textureFormat);
+    for(int y = 0; y < textureHeight; ++y){
+        out.writeRawData(reinterpret_cast<const char*>(image.constScanLine(y)), bytesPerLine);
+    }
+}
+
+bool PuzzleTexture::read(QDataStream& in){
+    quint32 format = 0;
+    qint32 width = 0;
+    qint32 height = 0;
+    in >> format >> width >> height;
+    if(in.status() != QDataStream::Ok || width <= 0 || height <= 0
+            || width > MAX_TEXTURE_SIDE || height > MAX_TEXTURE_SIDE){
+        return false;
+    }
+    textureFormat = static_cast<Format>(format);
+    textureWidth = width;
+    textureHeight = height;
+
+    if(textureFormat == Format_YUV420){
+        in >> luma >> chromaBlue >> chromaRed;
+        const int chromaSize = ((width + 1) / 2) * ((height + 1) / 2);
+        return in.status() == QDataStream::Ok && luma.size() == width * height
+                && chromaBlue.size() == chromaSize && chromaRed.size() == chromaSize;
+    }
+
+    QImage::Format imageFormat;
+    switch(textureFormat){
+    case Format_ARGB32:
+        imageFormat = QImage::Format_ARGB32;
+        break;
+    case Format_RGB565:
+        imageFormat = QImage::Format_RGB16;
+        break;
+    case Format_Indexed8:
+        imageFormat = QImage::Format_Indexed8;
+        break;
+    default:
+        return false;
+    }
+    in >> colors;
+    if(in.status() != QDataStream::Ok
+            || (textureFormat == Format_Indexed8 && (colors.isEmpty() || colors.size() > MAX_INDEXED_COLORS))){
+        return false;
+    }
+    image = QImage(width, height, imageFormat);
+    if(image.isNull()){
+        return false;
+    }
+    if(textureFormat == Format_Indexed8){
+        image.setColorTable(colors);
+    }
+    const int bytesPerLine = width * bytesPerPixel(textureFormat);
+    for(int y = 0; y < height; ++y){
+        if(in.readRawData(reinterpret_cast<char*>(image.scanLine(y)), bytesPerLine) != bytesPerLine){
+            return false;
+        }
+        // pixel() does not check indexes of palette
+        if(textureFormat == Format_Indexed8){
+            const uchar* indexLine = image.constScanLine(y);
+            for(int x = 0; x < width; ++x){
+                if(indexLine[x] >= colors.size()){
+                    return false;
+                }
+            }
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
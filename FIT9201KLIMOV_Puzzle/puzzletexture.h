@@ -0,0 +1,59 @@
+#ifndef PUZZLETEXTURE_H
+#define PUZZLETEXTURE_H
+
+#include <QImage>
+#include <QVector>
+#include <QByteArray>
+#include <QDataStream>
+
+// texture of puzzle in compact internal format, pixels are decoded on sampling
+class PuzzleTexture
+{
+public:
+    enum Format{
+        Format_Auto = 0,    // chosen by content of image, Indexed8 or ARGB32
+        Format_ARGB32 = 1,  // 32 bit, only format keeping full alpha with many colors
+        Format_RGB565 = 2,  // 16 bit, opaque, lossy: used only if it is asked
+        Format_Indexed8 = 3,// 8 bit index in exact palette of up to 256 colors (with alpha), lossy with more colors
+        Format_YUV420 = 4,  // 12 bit, opaque, luma per pixel and chroma per 2x2 pixels
+        Format_AutoLossy = 5// as Auto, but opaque images with many colors are kept in YUV420 or RGB565
+    };
+
+    PuzzleTexture();
+    // convert 'image' to 'format', source image is not kept
+    PuzzleTexture(const QImage& image, Format format);
+
+    bool isNull()const {return textureWidth <= 0 || textureHeight <= 0;}
+    int width()const {return textureWidth;}
+    int height()const {return textureHeight;}
+    Format format()const {return textureFormat;}
+
+    QRgb pixel(int x, int y)const;
+    QRgb pixel(const QPoint& point)const {return pixel(point.x(), point.y());}
+
+    void write(QDataStream& out)const;
+    bool read(QDataStream& in);
+
+    // smallest format keeping 'image' without loss, or with loss of opaque image if 'allowLossy'
+    static Format chooseFormat(const QImage& image, bool allowLossy);
+    // format by its name in command line: auto, lossy, argb32, rgb565, indexed8, yuv420
+    static bool parseFormat(const QString& name, Format& format);
+private:
+    void setIndexed8(const QImage& argb);
+    void setYUV420(const QImage& image);
+    QRgb pixelYUV420(int x, int y)const;
+
+    Format textureFormat;
+    int textureWidth;
+    int textureHeight;
+    // pixels of ARGB32, RGB565 and Indexed8 formats
+    QImage image;
+    // color table of Indexed8, kept out of 'image' to not copy it on each pixel
+    QVector<QRgb> colors;
+    // planes of YUV420 format
+    QByteArray luma;
+    QByteArray chromaBlue;
+    QByteArray chromaRed;
+};
+
+#endif // PUZZLETEXTURE_H
@@ -5,17 +5,29 @@
 #include <QImage>
 #include <QTimer>
 #include <QTime>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QSharedPointer>
 
 #include "ui_mainwindow.h"
 
-#include "triangleanimationmodel.h"
+#include "animationclock.h"
+#include "puzzleloader.h"
+#include "puzzlescene.h"
+#include "tracerecorder.h"
 
 class PuzzleWindow : public QMainWindow, public  Ui_PuzzleWindow
 {
     Q_OBJECT
 public:
-    explicit PuzzleWindow(QWidget *parent = 0);
+    // 'textureFormat' is internal format of loaded picture, Format_Auto picks the smallest lossless one
+    explicit PuzzleWindow(PuzzleTexture::Format textureFormat = PuzzleTexture::Format_Auto, QWidget *parent = 0);
     ~PuzzleWindow();
+
+    // write all inputs to trace 'fileName', 'seed' is random seed of models
+    bool startRecording(const QString& fileName, uint seed);
+    // duration of animation cycle in milliseconds
+    void setCycleDuration(int cycleDuration){animationClock.setCycleDuration(cycleDuration);}
 protected:
     void paintEvent(QPaintEvent*);
     bool eventFilter(QObject *obj, QEvent *event);
@@ -27,28 +39,23 @@ private slots:
     void sl_onAlphaMixChanged(int);
     void sl_onDegreeChanged(int);
     void sl_onFilterChanged(int);
+    void sl_onScanlineChanged(int);
     void sl_onTimeout();
     void sl_onTimeoutProgress();
+    void sl_onPuzzleLoaded();
 private:
-    void setModelTextureCoordinates();
-
-    void setPuzzleArea();
-    void getProgress(int val, bool drawImmediately);
-    // calculate next animations on progress 'progress'
-    void onProgress(const float progress);
-    // bilinear filtaration to point 'point2Filter'
-    QRgb makeFilter(QPointF point2Filter, int& alpha);
+    // place settings panel and redraw after window size is changed
+    void updateLayout();
     bool isStopped;
-    bool isFiltered;
-    bool isAlphaMixered;
-    QImage puzzleArea;
     QTimer timer;
-    QImage puzzle;
-    QTime lastAnimatedTime;
+    AnimationClock animationClock;
     QTimer timerProgress;
+    QFutureWatcher<PuzzleData> puzzleLoading;
+    PuzzleScene scene;
 
-    QVector<float> progresses;
-    QVector<QSharedPointer<TriangleAnimationModel> > models;
+    QSharedPointer<TraceRecorder> traceRecorder;
+    // time of user inputs, used by prediction of dial moves
+    QElapsedTimer inputTime;
 };
 
 #endif // PUZZLEWINDOW_H
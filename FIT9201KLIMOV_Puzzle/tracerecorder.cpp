@@ -0,0 +1,26 @@
+#include "tracerecorder.h"
+
+TraceRecorder::TraceRecorder()
+{
+}
+
+bool TraceRecorder::open(const QString& fileName, uint seed){
+    file.setFileName(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+    out.setDevice(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << TRACE_MAGIC << TRACE_VERSION << static_cast<quint32>(seed);
+    elapsed.start();
+    return out.status() == QDataStream::Ok;
+}
+
+void TraceRecorder::record(TraceEvent::Type type, qint32 first, qint32 second){
+    if(!file.isOpen()){
+        return;
+    }
+    out << static_cast<quint32>(elapsed.elapsed()) << static_cast<quint8>(type) << first << second;
+    // trace must survive crash of application, it is what we want to reproduce
+    file.flush();
+}
@@ -0,0 +1,45 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QString>
+
+// one user input (or animation tick) of PuzzleWindow
+struct TraceEvent{
+    enum Type{
+        Type_Degree = 1,    // first: dial value
+        Type_Tick = 2,      // first: phase of animation clock, scaled
+        Type_Resize = 3,    // first: width, second: height
+        Type_Filter = 4,    // first: check state
+        Type_AlphaMix = 5,  // first: check state
+        Type_Scanline = 6,  // first: check state
+        Type_Init = 7
+    };
+    // animation phase [0, 1) is kept in trace as integer
+    static const qint32 PHASE_SCALE = 1 << 24;
+    quint32 time;   // milliseconds from start of recording
+    quint8 type;
+    qint32 first;
+    qint32 second;
+};
+
+// writes inputs to binary trace: header (magic, version, random seed) and events
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+
+    bool open(const QString& fileName, uint seed);
+    void record(TraceEvent::Type type, qint32 first = 0, qint32 second = 0);
+
+    static const quint32 TRACE_MAGIC = 0x505a5452; // "PZTR"
+    static const quint32 TRACE_VERSION = 1;
+private:
+    QFile file;
+    QDataStream out;
+    QElapsedTimer elapsed;
+};
+
+#endif // TRACERECORDER_H
@@ -0,0 +1,160 @@
+#include "tracereplayer.h"
+#include "puzzlescene.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtAlgorithms>
+
+#include <cassert>
+
+namespace{
+    // window of mainwindow.ui before its first resize
+    static const int INITIAL_WINDOW_WIDTH = 751;
+    static const int INITIAL_WINDOW_HEIGHT = 500;
+}
+
+TraceReplayer::TraceReplayer():seed(0)
+{
+}
+
+bool TraceReplayer::open(const QString& fileName){
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 traceSeed = 0;
+    in >> magic >> version >> traceSeed;
+    if(in.status() != QDataStream::Ok || magic != TraceRecorder::TRACE_MAGIC || version != TraceRecorder::TRACE_VERSION){
+        error = "not a trace or trace of other version";
+        return false;
+    }
+    seed = traceSeed;
+
+    events.clear();
+    while(!in.atEnd()){
+        TraceEvent event;
+        in >> event.time >> event.type >> event.first >> event.second;
+        if(in.status() != QDataStream::Ok){
+            // last event may be cut if application was killed during recording
+            break;
+        }
+        if(event.type < TraceEvent::Type_Degree || event.type > TraceEvent::Type_Init){
+            error = QString("unknown type %1 of event %2").arg(event.type).arg(events.size());
+            events.clear();
+            return false;
+        }
+        events.append(event);
+    }
+    return true;
+}
+
+void TraceReplayer::applyEvent(PuzzleScene& scene, const TraceEvent& event, float phasePerTick){
+    switch(event.type){
+    case TraceEvent::Type_Degree:
+        scene.setDegree(event.first, event.time);
+        break;
+    case TraceEvent::Type_Tick:
+        scene.setAnimationPhase(static_cast<float>(event.first) / TraceEvent::PHASE_SCALE, phasePerTick);
+        break;
+    case TraceEvent::Type_Resize:
+        scene.setAreaSize(PuzzleScene::areaSizeOfWindow(QSize(event.first, event.second)));
+        break;
+    case TraceEvent::Type_Filter:
+        scene.setFiltered(Qt::Unchecked != event.first);
+        break;
+    case TraceEvent::Type_AlphaMix:
+        scene.setAlphaMixered(Qt::Unchecked != event.first);
+        break;
+    case TraceEvent::Type_Scanline:
+        scene.setScanlineRendered(Qt::Unchecked != event.first);
+        break;
+    case TraceEvent::Type_Init:
+        scene.init();
+        break;
+    default:
+        assert(false && "Unknown trace event.");
+    }
+}
+
+FrameStats TraceReplayer::run(PuzzleScene& scene, bool realTime){
+    scene.setAreaSize(PuzzleScene::areaSizeOfWindow(QSize(INITIAL_WINDOW_WIDTH, INITIAL_WINDOW_HEIGHT)));
+    scene.renderPendingFrame();
+
+    QVector<qint64> frameTimes;
+    frameTimes.reserve(events.size());
+
+    qint64 allocations = 0;
+    qint64 steadyStateAllocations = 0;
+    // buffers of frame may grow on first frame after window size or render mode are changed
+    bool isWarmUp = false;
+
+    // animation prefetching expects the next tick as far as the previous one
+    float lastTickPhase = -1.f;
+
+    QElapsedTimer replayTime;
+    replayTime.start();
+    foreach(const TraceEvent& event, events){
+        if(realTime && replayTime.elapsed() < event.time){
+            QEventLoop loop;
+            QTimer::singleShot(static_cast<int>(event.time - replayTime.elapsed()), &loop, SLOT(quit()));
+            loop.exec();
+        }
+
+        float phasePerTick = 0.f;
+        if(event.type == TraceEvent::Type_Tick){
+            const float phase = static_cast<float>(event.first) / TraceEvent::PHASE_SCALE;
+            if(lastTickPhase >= 0.f){
+                phasePerTick = phase - lastTickPhase + ((phase < lastTickPhase) ? 1.f : 0.f);
+            }
+            lastTickPhase = phase;
+        }
+        else{
+            lastTickPhase = -1.f;
+        }
+
+        const int framesBefore = scene.getRenderedFrames();
+        QElapsedTimer frameTime;
+        frameTime.start();
+        applyEvent(scene, event, phasePerTick);
+        const bool isPendingDrawn = scene.renderPendingFrame();
+        const qint64 spent = frameTime.nsecsElapsed() / 1000;
+        if(scene.getRenderedFrames() != framesBefore){
+            frameTimes.append(spent);
+        }
+
+        isWarmUp = isWarmUp || event.type == TraceEvent::Type_Resize || event.type == TraceEvent::Type_Scanline;
+        if(isPendingDrawn){
+            allocations += scene.getFrameAllocations();
+            if(!isWarmUp){
+                steadyStateAllocations += scene.getFrameAllocations();
+            }
+            isWarmUp = false;
+        }
+    }
+
+    // jobs still rendering are waited for, so allocations of all of them are counted
+    scene.setPrefetchEnabled(false);
+    FrameStats stats = {frameTimes.size(), 0, 0, 0, 0, 0, allocations, steadyStateAllocations,
+                        static_cast<qint64>(scene.getPrefetchAllocations())};
+    if(frameTimes.isEmpty()){
+        return stats;
+    }
+    foreach(const qint64 time, frameTimes){
+        stats.total += time;
+    }
+    qSort(frameTimes);
+    stats.min = frameTimes.first();
+    stats.max = frameTimes.last();
+    stats.average = stats.total / frameTimes.size();
+    stats.percentile95 = frameTimes[(frameTimes.size() - 1) * 95 / 100];
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef TRACEREPLAYER_H
+#define TRACEREPLAYER_H
+
+#include <QVector>
+#include <QString>
+
+#include "tracerecorder.h"
+
+class PuzzleScene;
+
+// frame times of replay in microseconds
+struct FrameStats{
+    int frames;
+    qint64 total;
+    qint64 min;
+    qint64 average;
+    qint64 percentile95;
+    qint64 max;
+    // heap allocations of drawing, counted only if AllocationCounter is enabled
+    qint64 allocations;
+    // allocations of frames drawn with the same size and render mode as previous frame, expected to be 0
+    qint64 steadyStateAllocations;
+    // allocations of threads rendering frames in advance, they are not parts of frame times
+    qint64 prefetchAllocations;
+};
+
+// drives PuzzleScene by trace of TraceRecorder without window, so replay does not need display
+class TraceReplayer
+{
+public:
+    TraceReplayer();
+
+    // trace with unknown events is rejected, so replay never skips inputs
+    bool open(const QString& fileName);
+    // reason why open() failed
+    QString getError()const {return error;}
+    uint getSeed()const {return seed;}
+    // 'scene' has loaded puzzle, 'realTime' keeps delays between events, else events are replayed at full speed
+    FrameStats run(PuzzleScene& scene, bool realTime);
+private:
+    // input of window recorded in 'event', 'phasePerTick' is phase change since previous tick or 0
+    static void applyEvent(PuzzleScene& scene, const TraceEvent& event, float phasePerTick);
+
+    uint seed;
+    QVector<TraceEvent> events;
+    QString error;
+};
+
+#endif // TRACEREPLAYER_H
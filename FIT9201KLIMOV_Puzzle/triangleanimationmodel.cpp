@@ -5,13 +5,42 @@
 #include <cmath>
 #include <cassert>
 
+namespace{
+    static bool isRandGenerate = false;
+    // one random sequence for all threads (qrand() is per thread): models are made by loading thread
+    // and get new curves in GUI thread later, both never at the same time
+    static uint randomState = 1;
+    static const int RANDOM_MAX = 0x7fff;
+
+    // [0, RANDOM_MAX]
+    int nextRandom(){
+        randomState = randomState * 1103515245u + 12345u;
+        return static_cast<int>((randomState >> 16) & RANDOM_MAX);
+    }
+    // latest start of piece movement and shortest movement in parts of global progress
+    static const float MAX_OFFSET = 0.5f;
+    static const float MIN_DURATION = 0.3f;
+
+    // [0, 1]
+    float randomUnit(){
+        return static_cast<float>(nextRandom()) / RANDOM_MAX;
+    }
+}
+
 TriangleAnimationModel::TriangleAnimationModel(const QPointF& first, const QPointF& second, const QPointF& third):
     currentTriangle(Triangle<QPoint>(QPoint(-1, -1), QPoint(-1, -1), QPoint(-1, -1))),
     textureTriangle(Triangle<QPointF>(first, second, third)),
-    degree(-1), curve(BezeCurve(QPointF(0.f,0.f))), numPixelBorder(0), numPixelTriangle(0), numPixelTransparent(0)
+    degree(-1), curve(BezeCurve(QPointF(0.f,0.f))), offset(0.f), duration(1.f), numPixelBorder(0), numPixelTriangle(0), numPixelTransparent(0),
+    statisticsFrame(-1)
 {
     curve = BezeCurve(textureTriangle.middle());
     setNewDegree();
+    setNewTiming();
+}
+
+void TriangleAnimationModel::setNewCurve(){
+    curve.setNewCurve();
+    setNewTiming();
 }
 
 TriangleAnimationModel::BezeCurve::BezeCurve(const QPointF& _p3)
@@ -32,22 +61,27 @@ void TriangleAnimationModel::BezeCurve::setNewCurve(){
     setRandomPoints();
 }
 
-void TriangleAnimationModel::BezeCurve::setRandomPoints(){
-    QTime midnight(0, 0, 0);
-
-    static bool isRandGenerate = false;
+void TriangleAnimationModel::setRandomSeed(uint seed){
+    randomState = seed;
+    isRandGenerate = true;
+}
 
+void TriangleAnimationModel::initRandom(){
     if(!isRandGenerate){
-        qsrand(midnight.secsTo(QTime::currentTime()));
-        isRandGenerate = true;
+        QTime midnight(0, 0, 0);
+        setRandomSeed(midnight.secsTo(QTime::currentTime()));
     }
+}
+
+void TriangleAnimationModel::BezeCurve::setRandomPoints(){
+    initRandom();
 
-    p0 = QPointF((static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
-                (static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
-    p1 = QPointF((static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
-                (static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
-    p2 = QPointF((static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
-                (static_cast<float>(qrand() % RAND_MAX)) / (RAND_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
+    p0 = QPointF((static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
+                (static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
+    p1 = QPointF((static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
+                (static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
+    p2 = QPointF((static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5,   // [-0.5, 1.5]
+                (static_cast<float>(nextRandom() % RANDOM_MAX)) / (RANDOM_MAX - 1) * 2 - 0.5) ; // [-0.5, 1.5]
 
     assert(p0.x() >= -0.5f && p0.x() <= 1.5f);
     assert(p1.x() >= -0.5f && p1.x() <= 1.5f);
@@ -63,14 +97,20 @@ QPointF TriangleAnimationModel::getNextCurvePoint(float progress)const{
 }
 
 void TriangleAnimationModel::setNewDegree(){
-    QTime midday(12, 0, 0);
+    initRandom();
+    static const int MAX_DEGREE = 360;
+    degree = nextRandom() % (MAX_DEGREE);// [0, 359]
+}
 
-    static bool isRandGenerate = false;
+void TriangleAnimationModel::setNewTiming(){
+    initRandom();
+    offset = randomUnit() * MAX_OFFSET;
+    duration = MIN_DURATION + randomUnit() * (1.f - offset - MIN_DURATION);
 
-    if(isRandGenerate == false){
-        qsrand(midday.secsTo(QTime::currentTime()));
-        isRandGenerate = true;
-    }
-    static const int MAX_DEGREE = 360;
-    degree = qrand() % (MAX_DEGREE);// [0, 359]
+    assert(offset >= 0.f && duration > 0.f);
+    assert(offset + duration <= 1.f + 0.0001f);
+}
+
+float TriangleAnimationModel::getPieceProgress(float progress)const{
+    return qBound(0.f, (progress - offset) / duration, 1.f);
 }
@@ -16,14 +16,22 @@ public:
     int getPixelBorder()const{return numPixelBorder;}
     int getPixelTriangle()const{return numPixelTriangle;}
     int getPixelTransparent()const{return numPixelTransparent;}
+    // number of frame pixel counters are calculated on
+    void setStatisticsFrame(int _statisticsFrame){statisticsFrame = _statisticsFrame;}
+    int getStatisticsFrame()const{return statisticsFrame;}
     QPoint getFirst()const {return currentTriangle.getFirst();}
     QPoint getSecond()const {return currentTriangle.getSecond();}
     QPoint getThird()const {return currentTriangle.getThird();}
 
-    void setNewCurve(){curve.setNewCurve();}
+    // new way of piece and new time it moves on
+    void setNewCurve();
     void setCurrentTriangle(const Triangle<QPoint>& current){
        currentTriangle.changeApexs(current.getFirst(), current.getSecond(), current.getThird());
     }
+    // the same without temporary triangle
+    void setCurrentTriangle(const QPoint& first, const QPoint& second, const QPoint& third){
+       currentTriangle.changeApexs(first, second, third);
+    }
     bool interSect(const QPoint& point)const{
         return (currentTriangle.pointLocation(point) == Location_in);
     }
@@ -32,7 +40,14 @@ public:
     const Triangle<QPointF>& getTextureTriangle()const {return textureTriangle;}
     QPointF getNextCurvePoint(float progress) const;
     void setNewDegree();
+    // piece moves only on [offset, offset + duration] of global progress and rests out of it,
+    // so pieces fly at staggered times
+    float getPieceProgress(float progress) const;
+    void setNewTiming();
+    // fix random sequence of all models, it is taken from time if it is not called
+    static void setRandomSeed(uint seed);
 private:
+    static void initRandom();
     // (1 - t)^3 * Po + 3t * (1 - t)^2 * P1 + 3t^2 * (1-t) * P2 + t^3 * P3
     class BezeCurve{
     public:
@@ -50,9 +65,12 @@ private:
     Triangle<QPointF> textureTriangle;
     int degree;
     BezeCurve curve;
+    float offset;
+    float duration;
     int numPixelBorder;
     int numPixelTriangle;
     int numPixelTransparent;
+    int statisticsFrame;
 };
 
 #endif // TRIANGLEANIMATIONMODEL_H